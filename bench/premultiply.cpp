@@ -0,0 +1,87 @@
+/*=============================================================================
+   Copyright (c) 2016-2024 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/support/detail/pixel_convert.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// Times the conversion of a 4096x4096 straight RGBA image to cairo's
+// premultiplied ARGB32, as done by the image decoders. Run a release build.
+///////////////////////////////////////////////////////////////////////////////
+namespace
+{
+   using namespace cycfi::elements;
+
+   constexpr std::size_t width = 4096;
+   constexpr std::size_t height = 4096;
+   constexpr std::size_t num_pixels = width * height;
+   constexpr int num_runs = 10;
+
+   // The old conversion: swizzle RGBA to BGRA, one byte at a time, without
+   // premultiplying the alpha.
+   void swizzle(std::uint8_t const* src, std::uint8_t* dest, std::size_t n, bool /* swap_rb */)
+   {
+      for (std::size_t i = 0; i != n; ++i, src += 4, dest += 4)
+      {
+         dest[0] = src[2];
+         dest[1] = src[1];
+         dest[2] = src[0];
+         dest[3] = src[3];
+      }
+   }
+
+   using convert_function = void(*)(std::uint8_t const*, std::uint8_t*, std::size_t, bool);
+
+   // Convert the image row by row, like the decoders, and return the best
+   // time of num_runs, in milliseconds.
+   double best_time(convert_function f, std::vector<std::uint8_t> const& src, std::vector<std::uint8_t>& dest)
+   {
+      using clock = std::chrono::steady_clock;
+      auto best = clock::duration::max();
+      for (int run = 0; run != num_runs; ++run)
+      {
+         auto start = clock::now();
+         for (std::size_t y = 0; y != height; ++y)
+            f(src.data() + y * width * 4, dest.data() + y * width * 4, width, true);
+         best = std::min(best, clock::now() - start);
+      }
+      return std::chrono::duration<double, std::milli>(best).count();
+   }
+}
+
+int main()
+{
+   std::vector<std::uint8_t> src(num_pixels * 4);
+   std::mt19937 rng{42};
+   std::uniform_int_distribution<int> byte{0, 255};
+   for (auto& b : src)
+      b = std::uint8_t(byte(rng));
+
+   std::vector<std::uint8_t> scalar(src.size());
+   std::vector<std::uint8_t> vectorized(src.size());
+
+   auto old_ms = best_time(swizzle, src, scalar);
+   auto scalar_ms = best_time(detail::premultiply_pixels_scalar, src, scalar);
+   auto vectorized_ms = best_time(detail::premultiply_pixels, src, vectorized);
+
+   std::printf("%zux%zu RGBA to ARGB32, best of %d runs\n", width, height, num_runs);
+   std::printf("   old swizzle (no premultiply): %8.2f ms\n", old_ms);
+   std::printf("   premultiply, scalar:          %8.2f ms\n", scalar_ms);
+   std::printf("   premultiply, vectorized:      %8.2f ms\n", vectorized_ms);
+
+   if (scalar != vectorized)
+   {
+      std::printf("error: the scalar and vectorized results differ\n");
+      return 1;
+   }
+   return 0;
+}
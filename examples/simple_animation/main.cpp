@@ -6,21 +6,18 @@
 #include <elements.hpp>
 
 using namespace cycfi::elements;
-using namespace std::chrono_literals;
 
 float position = 0.0;
-constexpr float incr = 0.001;
-constexpr auto fps = 1000ms / 60;
+constexpr float speed = 0.06;    // Per second
 
-void animate(view& view_, vport_element& port)
+bool animate(view& view_, vport_element& port, animation_tick& tick)
 {
-   position += incr;
-   if (position < 1.0)
-      view_.post(fps, [&]() { animate(view_, port); });
-   else
+   position += speed * std::chrono::duration<float>(tick.elapsed).count();
+   if (position > 1.0)
       position = 1.0;
    port.valign(position);
-   view_.refresh();
+   tick.damage = view_bounds(view_);
+   return position < 1.0;
 }
 
 int main(int argc, char* argv[])
@@ -34,7 +31,7 @@ int main(int argc, char* argv[])
    auto port = share(vport(image{"moving.png"}));
    view_.content(port);
 
-   view_.post(fps, [&]() { animate(view_, *port); });
+   view_.animate([&](animation_tick& tick) { return animate(view_, *port, tick); });
 
    _app.run();
    return 0;
@@ -7,6 +7,7 @@
 #define ELEMENTS_MAY_4_2016
 
 #include <elements/element/align.hpp>
+#include <elements/element/async_image.hpp>
 #include <elements/element/button.hpp>
 #include <elements/element/child_window.hpp>
 #include <elements/element/collapsable.hpp>
@@ -17,6 +18,7 @@
 #include <elements/element/events_intercept.hpp>
 #include <elements/element/floating.hpp>
 #include <elements/element/flow.hpp>
+#include <elements/element/frame_graph.hpp>
 #include <elements/element/grid.hpp>
 #include <elements/element/image.hpp>
 #include <elements/element/indirect.hpp>
@@ -188,14 +188,14 @@ namespace cycfi::elements
    template <concepts::Element Subject>
    inline view_limits halign_element<Subject>::limits(basic_context const& ctx) const
    {
-      auto e_limits = this->subject().limits(ctx);
+      auto e_limits = ELEMENTS_INSTRUMENT_CALL(limits, this->subject(), this->subject().limits(ctx));
       return {{e_limits.min.x, e_limits.min.y}, {full_extent, e_limits.max.y}};
    }
 
    template <concepts::Element Subject>
    inline void halign_element<Subject>::prepare_subject(context& ctx)
    {
-      view_limits    e_limits          = this->subject().limits(ctx);
+      view_limits    e_limits          = ELEMENTS_INSTRUMENT_CALL(limits, this->subject(), this->subject().limits(ctx));
       float          elem_width        = e_limits.min.x;
       float          available_width   = ctx.bounds.width();
 
@@ -333,14 +333,14 @@ namespace cycfi::elements
    template <concepts::Element Subject>
    inline view_limits valign_element<Subject>::limits(basic_context const& ctx) const
    {
-      auto e_limits = this->subject().limits(ctx);
+      auto e_limits = ELEMENTS_INSTRUMENT_CALL(limits, this->subject(), this->subject().limits(ctx));
       return {{e_limits.min.x, e_limits.min.y}, {e_limits.max.x, full_extent}};
    }
 
    template <concepts::Element Subject>
    inline void valign_element<Subject>::prepare_subject(context& ctx)
    {
-      auto  e_limits          = this->subject().limits(ctx);
+      auto  e_limits          = ELEMENTS_INSTRUMENT_CALL(limits, this->subject(), this->subject().limits(ctx));
       float elem_height       = e_limits.min.y;
       float available_height  = ctx.bounds.height();
 
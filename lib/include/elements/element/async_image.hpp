@@ -0,0 +1,67 @@
+/*=============================================================================
+   Copyright (c) 2016-2024 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_ASYNC_IMAGE_OCTOBER_18_2026)
+#define ELEMENTS_ASYNC_IMAGE_OCTOBER_18_2026
+
+#include <elements/element/element.hpp>
+#include <elements/support/pixmap.hpp>
+#include <infra/filesystem.hpp>
+#include <memory>
+
+namespace cycfi::elements
+{
+   /**
+    * \class async_image
+    *
+    * \brief
+    *    An image that is loaded and decoded on a worker thread.
+    *
+    *    The load starts when the element is first laid out or drawn, via
+    *    `view::async`. Until the image is ready, `async_image` draws a
+    *    placeholder. Once ready, the image is swapped in on the view's
+    *    thread and only the element is refreshed. The image is scaled to
+    *    fit the element's bounds, keeping its aspect ratio.
+    *
+    *    If `size` is given, the element has a fixed size. Otherwise, the
+    *    element is empty (zero sized) until the image is ready, then takes
+    *    the size of the image, and the view is laid out again.
+    *
+    *    Images are loaded through the pixmap cache (see `load_pixmap`). An
+    *    image that is already cached is available immediately. A pending
+    *    load is dropped when the element, or the view, is destroyed.
+    */
+   class async_image : public element
+   {
+   public:
+                              async_image(fs::path path, float scale = 1, extent size = {});
+                              async_image(async_image&& rhs);
+
+                              async_image(async_image const&) = delete;
+      async_image&            operator=(async_image const&) = delete;
+
+      view_limits             limits(basic_context const& ctx) const override;
+      void                    layout(context const& ctx) override;
+      void                    draw(context const& ctx) override;
+
+      bool                    is_ready() const                 { return bool(_pixmap); }
+      bool                    has_failed() const;
+      pixmap_ptr              get_image() const                { return _pixmap; }
+
+   private:
+
+      struct state;
+      using state_ptr = std::shared_ptr<state>;
+
+      void                    load(context const& ctx);
+      void                    draw_placeholder(context const& ctx);
+
+      pixmap_ptr              _pixmap;
+      state_ptr               _state;
+      extent                  _size;
+   };
+}
+
+#endif
@@ -38,7 +38,7 @@ namespace cycfi::elements
    inline view_limits
    vcollapsable_element<Subject>::limits(basic_context const& ctx) const
    {
-      auto e_limits = this->subject().limits(ctx);
+      auto e_limits = ELEMENTS_INSTRUMENT_CALL(limits, this->subject(), this->subject().limits(ctx));
       return is_collapsed?
          view_limits{{e_limits.min.x, 0.0f}, {e_limits.max.x, 0.0f}} :
          e_limits;
@@ -48,7 +48,7 @@ namespace cycfi::elements
    inline void vcollapsable_element<Subject>::draw(context const& ctx)
    {
       if (!is_collapsed)
-         this->subject().draw(ctx);
+         ELEMENTS_INSTRUMENT_CALL(draw, this->subject(), this->subject().draw(ctx));
    }
 
    template <concepts::Element Subject>
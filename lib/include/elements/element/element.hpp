@@ -65,6 +65,7 @@ namespace cycfi::elements
       virtual void            layout(context const& ctx);
       virtual void            refresh(context const& ctx, element& e, int outward = 0);
       void                    refresh(context const& ctx, int outward = 0);
+      virtual void            damaged(context const& ctx);
 
       using context_function = std::function<void(context const& ctx)>;
       virtual void            in_context_do(context const& ctx, element& e, context_function f);
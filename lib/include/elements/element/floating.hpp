@@ -7,6 +7,7 @@
 #define ELEMENTS_FLOATING_JUNE_9_2016
 
 #include <elements/element/proxy.hpp>
+#include <elements/support/pixmap.hpp>
 #include <infra/support.hpp>
 
 namespace cycfi::elements
@@ -17,6 +18,19 @@ namespace cycfi::elements
     * \brief
     *    A proxy that allows a given subject to be treated as a floating
     *    element with explicit bounds.
+    *
+    *    A floating element may optionally be drawn from a cached surface
+    *    (see `cache_surface`). The subject is rendered to the cache only
+    *    when it changes, so moving the floating element (e.g. dragging a
+    *    child window around) only blits the cache. The cache is invalidated
+    *    when the floating element is resized or laid out, and when an
+    *    element inside the subject requests a refresh (see
+    *    `element::damaged`), except for the refreshes of the drags that
+    *    move the floating element. Call `invalidate()` after changing the
+    *    subject by other means.
+    *
+    *    Only the floating element is cached. The layers beneath are redrawn
+    *    as usual, limited to the area the floating element uncovers.
     */
    class floating_element : public proxy_base
    {
@@ -25,18 +39,38 @@ namespace cycfi::elements
                                : _bounds(bounds)
                               {}
 
+      // Room around the bounds for the subject's drop shadow (see draw_panel)
+      static constexpr float  shadow_margin = 8;
+
       view_limits             limits(basic_context const& ctx) const override;
       void                    prepare_subject(context& ctx) override;
+      void                    draw(context const& ctx) override;
+      void                    layout(context const& ctx) override;
+      void                    refresh(context const& ctx, element& element, int outward = 0) override;
+      void                    damaged(context const& ctx) override;
+
+      void                    drag(context const& ctx, mouse_button btn) override;
 
       rect                    bounds() const;
       void                    bounds(rect bounds_);
+      rect                    damage_bounds() const;
 
       void                    minimize(context& ctx);
       void                    maximize(context& ctx);
 
+      void                    cache_surface(bool state);
+      bool                    cache_surface() const         { return _cache_surface; }
+      void                    invalidate()                  { _cache_valid = false; }
+
    private:
 
       rect                    _bounds;
+      bool                    _cache_surface = false;
+      bool                    _cache_valid = false;
+      bool                    _dragging = false;
+      bool                    _drag_damaged = false;
+      float                   _cache_ratio = 0;
+      pixmap_ptr              _cache;
    };
 
    /**
@@ -90,6 +124,16 @@ namespace cycfi::elements
    {
       _bounds = bounds_;
    }
+
+   /**
+    * \brief
+    *    Get the area that needs to be redrawn when the `floating_element`
+    *    moves: the bounds, plus room for the subject's drop shadow.
+    */
+   inline rect floating_element::damage_bounds() const
+   {
+      return _bounds.inset(-shadow_margin);
+   }
 }
 
 #endif
@@ -0,0 +1,58 @@
+/*=============================================================================
+   Copyright (c) 2016-2024 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_FRAME_GRAPH_OCTOBER_18_2026)
+#define ELEMENTS_FRAME_GRAPH_OCTOBER_18_2026
+
+#include <elements/element/element.hpp>
+
+namespace cycfi::elements
+{
+   /**
+    * \class frame_graph_element
+    *
+    * \brief
+    *    An overlay that plots the view's recent frame times as a bar graph.
+    *    Each bar is a `view::draw` frame, split into its set_limits, layout
+    *    and draw phases. A horizontal line marks the frame budget.
+    *
+    *    The graph requires a library built with
+    *    `ELEMENTS_ENABLE_INSTRUMENTATION`. Otherwise, it draws nothing.
+    */
+   class frame_graph_element : public element
+   {
+   public:
+                              frame_graph_element(
+                                 extent size = {256, 64}
+                               , float budget_ms = 1000.0f / 60
+                              );
+
+      view_limits             limits(basic_context const& ctx) const override;
+      void                    draw(context const& ctx) override;
+
+   private:
+
+      extent                  _size;
+      float                   _budget_ms;
+   };
+
+   /**
+    * \brief
+    *    Create a frame_graph_element.
+    *
+    * \param size
+    *    The size of the graph.
+    *
+    * \param budget_ms
+    *    The frame budget, in milliseconds. The graph's vertical scale spans
+    *    twice the budget.
+    */
+   inline auto frame_graph(extent size = {256, 64}, float budget_ms = 1000.0f / 60)
+   {
+      return frame_graph_element{size, budget_ms};
+   }
+}
+
+#endif
@@ -37,7 +37,7 @@ namespace cycfi::elements
    inline void hidable_element<Subject>::draw(context const& ctx)
    {
       if (!is_hidden)
-         this->subject().draw(ctx);
+         ELEMENTS_INSTRUMENT_CALL(draw, this->subject(), this->subject().draw(ctx));
    }
 
    template <concepts::Element Subject>
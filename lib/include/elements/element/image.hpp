@@ -10,6 +10,8 @@
 #include <elements/element/proxy.hpp>
 #include <elements/support/canvas.hpp>
 #include <elements/support/pixmap.hpp>
+#include <elements/support/pixmap_atlas.hpp>
+#include <elements/support/tiled_pixmap.hpp>
 #include <infra/filesystem.hpp>
 #include <memory>
 
@@ -24,8 +26,9 @@ namespace cycfi::elements
     *    The `image` class provides functionalities such as scaling, fitting
     *    to available space, drawing, and setting/retrieving the image
     *    source. The image source can be either an `image_ptr` (a pointer to
-    *    an image) or a filesystem path to an image file (`fs::path`). JPEG,
-    *    PNG and WEBP images are supported.
+    *    an image), a filesystem path to an image file (`fs::path`), or a
+    *    region of a pixmap atlas (`atlas_region`). JPEG, PNG and WEBP images
+    *    are supported.
     */
    class image : public element
    {
@@ -40,6 +43,7 @@ namespace cycfi::elements
                               image(fs::path const& path, float scale = 1);
                               image(fs::path const& path, fit_enum);
                               image(pixmap_ptr pixmap_);
+                              image(atlas_region const& region);
 
       virtual point           size() const;
       view_limits             limits(basic_context const& ctx) const override;
@@ -52,13 +56,45 @@ namespace cycfi::elements
    protected:
 
       elements::pixmap&       pixmap() const  { return *_pixmap.get(); }
+      rect                    image_bounds() const;
 
    private:
 
       pixmap_ptr              _pixmap;
+      rect                    _region;        // Empty: the whole pixmap
       bool                    _fit = false;
    };
 
+   /**
+    * \class tiled_image
+    *
+    * \brief
+    *    An image element for very large images (see `tiled_pixmap`). Only
+    *    the visible part of the image is decoded and drawn, at the
+    *    resolution it is displayed at, so it can be placed in a scroller
+    *    and zoomed (e.g. via `scale_element`) with bounded memory use.
+    *    Tiles are decoded in the background, on the shared executor. Until
+    *    they arrive, coarser tiles (if any) are drawn in their place.
+    */
+   class tiled_image : public element
+   {
+   public:
+
+      using tiled_pixmap_ptr = std::shared_ptr<tiled_pixmap>;
+
+                              tiled_image(fs::path const& path, float scale = 1);
+                              tiled_image(tiled_pixmap_ptr pixmap_);
+
+      view_limits             limits(basic_context const& ctx) const override;
+      void                    draw(context const& ctx) override;
+
+      tiled_pixmap_ptr        get_image() const { return _pixmap; }
+
+   private:
+
+      tiled_pixmap_ptr        _pixmap;
+   };
+
    ////////////////////////////////////////////////////////////////////////////
 	// Elements uses gizmos for user interface images such as buttons, frames etc.
    // Basically a gizmo is a resizeable image. The unique feature is its ability
@@ -92,6 +128,7 @@ namespace cycfi::elements
    public:
                               gizmo(char const* filename, float scale = 1);
                               gizmo(pixmap_ptr pixmap_);
+                              gizmo(atlas_region const& region);
 
       view_limits             limits(basic_context const& ctx) const override;
       void                    draw(context const& ctx) override;
@@ -102,6 +139,7 @@ namespace cycfi::elements
    public:
                               hgizmo(char const* filename, float scale = 1);
                               hgizmo(pixmap_ptr pixmap_);
+                              hgizmo(atlas_region const& region);
 
       view_limits             limits(basic_context const& ctx) const override;
       void                    draw(context const& ctx) override;
@@ -112,6 +150,7 @@ namespace cycfi::elements
    public:
                               vgizmo(char const* filename, float scale = 1);
                               vgizmo(pixmap_ptr pixmap_);
+                              vgizmo(atlas_region const& region);
 
       view_limits             limits(basic_context const& ctx) const override;
       void                    draw(context const& ctx) override;
@@ -131,6 +170,7 @@ namespace cycfi::elements
    {
    public:
                               basic_sprite(char const* filename, float height, float scale = 1);
+                              basic_sprite(atlas_region const& region, float height);
 
       view_limits             limits(basic_context const& ctx) const override;
 
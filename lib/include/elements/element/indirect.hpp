@@ -7,6 +7,7 @@
 #define ELEMENTS_REFERENCE_APRIL_10_2016
 
 #include <elements/element/element.hpp>
+#include <elements/support/instrument.hpp>
 #include <functional>
 
 namespace cycfi::elements
@@ -180,7 +181,7 @@ namespace cycfi::elements
    inline view_limits
    indirect<Base>::limits(basic_context const& ctx) const
    {
-      return this->get().limits(ctx);
+      return ELEMENTS_INSTRUMENT_CALL(limits, this->get(), this->get().limits(ctx));
    }
 
    template <concepts::Element Base>
@@ -206,14 +207,14 @@ namespace cycfi::elements
    inline void
    indirect<Base>::draw(context const& ctx)
    {
-      this->get().draw(ctx);
+      ELEMENTS_INSTRUMENT_CALL(draw, this->get(), this->get().draw(ctx));
    }
 
    template <concepts::Element Base>
    inline void
    indirect<Base>::layout(context const& ctx)
    {
-      this->get().layout(ctx);
+      ELEMENTS_INSTRUMENT_CALL(layout, this->get(), this->get().layout(ctx));
    }
 
    template <concepts::Element Base>
@@ -52,6 +52,7 @@ namespace cycfi::elements
    private:
 
       bool                    _is_enabled = true;
+      mutable cached_font     _font_cache;
    };
 
    namespace concepts
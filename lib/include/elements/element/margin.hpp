@@ -89,7 +89,7 @@ namespace cycfi::elements
    template <concepts::Rect Rect, concepts::Element Subject>
    inline view_limits margin_element<Rect, Subject>::limits(basic_context const& ctx) const
    {
-      auto r = this->subject().limits(ctx);
+      auto r = ELEMENTS_INSTRUMENT_CALL(limits, this->subject(), this->subject().limits(ctx));
 
       r.min.x += _margin.left + _margin.right;
       r.max.x += _margin.left + _margin.right;
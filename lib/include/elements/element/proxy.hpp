@@ -7,6 +7,7 @@
 #define ELEMENTS_PROXY_APRIL_10_2016
 
 #include <elements/element/element.hpp>
+#include <elements/support/instrument.hpp>
 #include <type_traits>
 
 namespace cycfi::elements
@@ -52,7 +52,7 @@ namespace cycfi::elements
    template <concepts::Element Subject>
    inline view_limits size_element<Subject>::limits(basic_context const& ctx) const
    {
-      auto  e_limits = this->subject().limits(ctx);
+      auto  e_limits = ELEMENTS_INSTRUMENT_CALL(limits, this->subject(), this->subject().limits(ctx));
       float size_x = _size.x;
       float size_y = _size.y;
       clamp(size_x, e_limits.min.x, e_limits.max.x);
@@ -112,7 +112,7 @@ namespace cycfi::elements
    template <concepts::Element Subject>
    inline view_limits hsize_element<Subject>::limits(basic_context const& ctx) const
    {
-      auto  e_limits = this->subject().limits(ctx);
+      auto  e_limits = ELEMENTS_INSTRUMENT_CALL(limits, this->subject(), this->subject().limits(ctx));
       float width = _width;
       clamp(width, e_limits.min.x, e_limits.max.x);
       return {{width, e_limits.min.y}, {width, e_limits.max.y}};
@@ -169,7 +169,7 @@ namespace cycfi::elements
    template <concepts::Element Subject>
    inline view_limits vsize_element<Subject>::limits(basic_context const& ctx) const
    {
-      auto  e_limits = this->subject().limits(ctx);
+      auto  e_limits = ELEMENTS_INSTRUMENT_CALL(limits, this->subject(), this->subject().limits(ctx));
       float height = _height;
       clamp(height, e_limits.min.y, e_limits.max.y);
       return {{e_limits.min.x, height}, {e_limits.max.x, height}};
@@ -222,7 +222,7 @@ namespace cycfi::elements
    template <concepts::Element Subject>
    inline view_limits min_size_element<Subject>::limits(basic_context const& ctx) const
    {
-      auto  e_limits = this->subject().limits(ctx);
+      auto  e_limits = ELEMENTS_INSTRUMENT_CALL(limits, this->subject(), this->subject().limits(ctx));
       float size_x = _size.x;
       float size_y = _size.y;
       clamp(size_x, e_limits.min.x, e_limits.max.x);
@@ -283,7 +283,7 @@ namespace cycfi::elements
    template <concepts::Element Subject>
    inline view_limits hmin_size_element<Subject>::limits(basic_context const& ctx) const
    {
-      auto e_limits = this->subject().limits(ctx);
+      auto e_limits = ELEMENTS_INSTRUMENT_CALL(limits, this->subject(), this->subject().limits(ctx));
       float width = _size > 0? _size : e_limits.min.x + -_size;
       clamp(width, e_limits.min.x, e_limits.max.x);
       return {{width, e_limits.min.y}, e_limits.max};
@@ -323,7 +323,7 @@ namespace cycfi::elements
    template <concepts::Element Subject>
    inline view_limits hmin_element<Subject>::limits(basic_context const& ctx) const
    {
-      auto  e_limits = this->subject().limits(ctx);
+      auto  e_limits = ELEMENTS_INSTRUMENT_CALL(limits, this->subject(), this->subject().limits(ctx));
       return {e_limits.min, {e_limits.min.x, e_limits.max.y}};
    }
 
@@ -364,7 +364,7 @@ namespace cycfi::elements
    template <concepts::Element Subject>
    inline view_limits vmin_size_element<Subject>::limits(basic_context const& ctx) const
    {
-      auto  e_limits = this->subject().limits(ctx);
+      auto  e_limits = ELEMENTS_INSTRUMENT_CALL(limits, this->subject(), this->subject().limits(ctx));
       float height = _height;
       clamp(height, e_limits.min.y, e_limits.max.y);
       return {{e_limits.min.x, height}, e_limits.max};
@@ -416,7 +416,7 @@ namespace cycfi::elements
    template <concepts::Element Subject>
    inline view_limits max_size_element<Subject>::limits(basic_context const& ctx) const
    {
-      auto  e_limits = this->subject().limits(ctx);
+      auto  e_limits = ELEMENTS_INSTRUMENT_CALL(limits, this->subject(), this->subject().limits(ctx));
       float size_x = _size.x;
       float size_y = _size.y;
       clamp(size_x, e_limits.min.x, e_limits.max.x);
@@ -470,7 +470,7 @@ namespace cycfi::elements
    template <concepts::Element Subject>
    inline view_limits hmax_size_element<Subject>::limits(basic_context const& ctx) const
    {
-      auto  e_limits = this->subject().limits(ctx);
+      auto  e_limits = ELEMENTS_INSTRUMENT_CALL(limits, this->subject(), this->subject().limits(ctx));
       float size_x = _size;
       clamp(size_x, e_limits.min.x, e_limits.max.x);
       return {{e_limits.min.x, e_limits.min.y}, {size_x, e_limits.max.y}};
@@ -520,7 +520,7 @@ namespace cycfi::elements
    template <concepts::Element Subject>
    inline view_limits vmax_size_element<Subject>::limits(basic_context const& ctx) const
    {
-      auto  e_limits = this->subject().limits(ctx);
+      auto  e_limits = ELEMENTS_INSTRUMENT_CALL(limits, this->subject(), this->subject().limits(ctx));
       float size_y = _size;
       clamp(size_y, e_limits.min.y, e_limits.max.y);
       return {{e_limits.min.x, e_limits.min.y}, {size_y, e_limits.max.y}};
@@ -696,7 +696,7 @@ namespace cycfi::elements
    inline view_limits
    limit_element<Subject>::limits(basic_context const& ctx) const
    {
-      auto l = this->subject().limits(ctx);
+      auto l = ELEMENTS_INSTRUMENT_CALL(limits, this->subject(), this->subject().limits(ctx));
       clamp_min(l.min.x, _limits.min.x);
       clamp_min(l.min.y, _limits.min.y);
       clamp_max(l.max.x, _limits.max.x);
@@ -744,7 +744,7 @@ namespace cycfi::elements
    inline view_limits
    scale_element<Subject>::limits(basic_context const& ctx) const
    {
-      auto l = this->subject().limits(ctx);
+      auto l = ELEMENTS_INSTRUMENT_CALL(limits, this->subject(), this->subject().limits(ctx));
       l.min.x *= _scale;
       l.min.y *= _scale;
       l.max.x *= _scale;
@@ -808,7 +808,7 @@ namespace cycfi::elements
    template <concepts::Element Subject>
    inline view_limits hcollapsible_element<Subject>::limits(basic_context const& ctx) const
    {
-      auto e_limits = this->subject().limits(ctx);
+      auto e_limits = ELEMENTS_INSTRUMENT_CALL(limits, this->subject(), this->subject().limits(ctx));
       if (is_collapsed())
          e_limits.min.x = e_limits.max.x = 0;
       return e_limits;
@@ -843,7 +843,7 @@ namespace cycfi::elements
    template <concepts::Element Subject>
    inline view_limits vcollapsible_element<Subject>::limits(basic_context const& ctx) const
    {
-      auto e_limits = this->subject().limits(ctx);
+      auto e_limits = ELEMENTS_INSTRUMENT_CALL(limits, this->subject(), this->subject().limits(ctx));
       if (is_collapsed())
          e_limits.min.y = e_limits.max.y = 0;
       return e_limits;
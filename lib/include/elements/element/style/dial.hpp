@@ -141,7 +141,7 @@ namespace cycfi::elements
    inline view_limits
    radial_styler_base<size, Subject>::limits(basic_context const& ctx) const
    {
-      auto sl = this->subject().limits(ctx);
+      auto sl = ELEMENTS_INSTRUMENT_CALL(limits, this->subject(), this->subject().limits(ctx));
 
       sl.min.x += size;
       sl.max.x += size;
@@ -126,7 +126,7 @@ namespace cycfi::elements
    inline view_limits
    slider_styler_base<size, Subject>::limits(basic_context const& ctx) const
    {
-      auto sl = this->subject().limits(ctx);
+      auto sl = ELEMENTS_INSTRUMENT_CALL(limits, this->subject(), this->subject().limits(ctx));
       if (sl.min.x < sl.min.y) // is vertical?
       {
          sl.min.x += size;
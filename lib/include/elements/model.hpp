@@ -6,11 +6,87 @@
 #if !defined(ELEMENTS_MODEL_DECEMBER_22_2023)
 #define ELEMENTS_MODEL_DECEMBER_22_2023
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <functional>
+#include <type_traits>
+#include <utility>
+#include <vector>
 #include <infra/support.hpp>
 
 namespace cycfi::elements
 {
+   class view;
+
+   namespace detail
+   {
+      /**
+       * \class observer_list
+       *
+       * \brief
+       *    A flat list of observer functions, notified in the order they
+       *    were added. The first `N` observers are stored in place, the
+       *    rest spill over to the heap. Observers are identified by stable
+       *    handles, for removal.
+       *
+       *    Observers may add and remove observers (including themselves)
+       *    while being notified. Removed observers are not called again, but
+       *    are only taken off the list when the outermost notification
+       *    returns. Added observers are held aside until then, so that the
+       *    running observers are never moved; they are notified from the
+       *    next notification on.
+       */
+      template <typename F, std::size_t N = 2>
+      class observer_list
+      {
+      public:
+
+         using handle = std::size_t;
+
+         handle               add(F f);
+         bool                 remove(handle h);
+         bool                 empty() const { return size() == 0; }
+         std::size_t          size() const { return _size - _removed + _added.size(); }
+
+                              template <typename... Args>
+         void                 notify(Args const&... args);
+
+      private:
+
+         struct entry
+         {
+            handle            id = 0;
+            F                 f;
+         };
+
+         entry&               at(std::size_t i);
+         entry const&         at(std::size_t i) const;
+         void                 append(entry e);
+         void                 compact();
+
+         using inline_storage = std::array<entry, N>;
+         using overflow_storage = std::vector<entry>;
+
+         inline_storage       _inline;
+         overflow_storage     _overflow;
+         std::size_t          _size = 0;
+         handle               _next_id = 1;
+
+         overflow_storage     _added;           // Added while notifying
+         std::size_t          _removed = 0;     // Removed while notifying
+         int                  _notifying = 0;   // Notification depth
+      };
+
+      // Models updated while a model_transaction is in effect, in the
+      // current thread, and the function that notifies each.
+      using pending_update = std::pair<void const*, void(*)(void*)>;
+      inline std::vector<pending_update>& pending_model_updates();
+      inline int&             model_transaction_depth();
+      inline void             commit_model_updates();
+   }
+
    /** \class model
     *
     * \brief
@@ -54,6 +130,7 @@ namespace cycfi::elements
       using param_type = cycfi::param_type<value_type>;
       using update_param_type = cycfi::param_type<value_type>;
       using update_function = std::function<void(update_param_type)>;
+      using observer_handle = std::size_t;
 
       derived_type&           derived();
       derived_type const&     derived() const;
@@ -64,11 +141,16 @@ namespace cycfi::elements
 
       void                    update();
       void                    update(param_type val);
-      void                    on_update(update_function f);
+      observer_handle         on_update(update_function f);
+      bool                    remove_on_update(observer_handle h);
 
    private:
 
-      update_function         _update;
+      static void             notify_pending(void* self);
+
+      using observers = detail::observer_list<update_function>;
+
+      observers               _observers;
    };
 
    /** \class value_model
@@ -195,6 +277,130 @@ namespace cycfi::elements
       delegate_type&          _ref;
    };
 
+   /** \class model_transaction
+    *
+    * \brief
+    *    While a `model_transaction` is in effect, updates to models in the
+    *    current thread are deferred. When the outermost transaction ends,
+    *    each updated model notifies its observers once, with its latest
+    *    value, in the order the models were first updated. Example:
+    *
+    * @code
+    *    {
+    *       model_transaction tx{view_};
+    *       for (auto& p : preset)
+    *          params[p.id] = p.value;
+    *    } // Observers are notified here, followed by a single refresh
+    * @endcode
+    *
+    *    When given a view, refreshes of the view are also deferred and
+    *    coalesced into a single refresh when the transaction ends. Models
+    *    updated in a transaction must outlive it.
+    */
+   class model_transaction
+   {
+   public:
+                              model_transaction();
+      explicit                model_transaction(view& view_);
+                              ~model_transaction();
+
+                              model_transaction(model_transaction const&) = delete;
+      model_transaction&      operator=(model_transaction const&) = delete;
+
+   private:
+
+      view*                   _view = nullptr;
+   };
+
+   /** \class atomic_model_base
+    *
+    * \brief
+    *    The non-template base of `atomic_model`. A view keeps a list of
+    *    these (see `view::track`) and delivers the pending ones, once per
+    *    frame, in the view's thread.
+    */
+   class atomic_model_base
+   {
+   public:
+                              atomic_model_base() = default;
+                              atomic_model_base(atomic_model_base const&) = delete;
+      atomic_model_base&      operator=(atomic_model_base const&) = delete;
+
+      bool                    is_tracked() const { return _view != nullptr; }
+
+   protected:
+
+                              ~atomic_model_base();
+
+      void                    mark_pending();
+
+   private:
+
+      friend class view;
+
+      virtual void            deliver() = 0;
+
+      std::atomic<bool>       _pending{false};
+      view*                   _view = nullptr;
+   };
+
+   /** \class atomic_model
+    *
+    * \brief
+    *    Class `atomic_model` is a derived class of `model` that may be set
+    *    from any thread (e.g. an audio thread) at any rate, without locks
+    *    or allocations.\n\n
+    *
+    *    The latest value is held in a triple buffer. Setting the value
+    *    does not call the update functions in the caller's thread. Instead,
+    *    the model is flagged as pending and the view it is tracked by (see
+    *    `view::track`) delivers it, once per frame, in the view's thread,
+    *    with only the most recent value. Intermediate values are dropped.
+    *
+    *    `set` (and assignment) may be called by one producer thread at a
+    *    time. `get`, `on_update` and `view::track` must be called in the
+    *    view's thread.
+    *
+    * \tparam T
+    *    The underlying type of the `atomic_model`. `T` must be trivially
+    *    copyable.
+    */
+   template <typename T>
+   class atomic_model : public model<T, atomic_model<T>>, public atomic_model_base
+   {
+   public:
+
+      static_assert(std::is_trivially_copyable_v<T>,
+         "atomic_model requires a trivially copyable type");
+
+      using base_type = model<T, atomic_model<T>>;
+      using value_type = typename base_type::value_type;
+      using param_type = typename base_type::param_type;
+
+                              atomic_model(param_type init = param_type{});
+
+      atomic_model&           operator=(param_type val);
+
+      value_type const&       get() const;
+      void                    set(param_type val);
+      void                    update();
+
+   private:
+
+      void                    deliver() override;
+
+      // Slot indices are in bits 0-1. The fresh bit is set when the middle
+      // slot holds a value the consumer has not seen yet.
+      static constexpr std::uint8_t fresh = 4;
+
+      using slots_type = std::array<value_type, 3>;
+
+      mutable slots_type      _slots;
+      std::uint8_t            _back = 0;              // Producer's slot
+      mutable std::uint8_t    _front = 2;             // Consumer's slot
+      mutable std::atomic<std::uint8_t> _middle{1};   // Shared slot
+   };
+
    template <typename ID, typename Delegate>
    auto extract(Delegate const& ref);
 
@@ -210,6 +416,158 @@ namespace cycfi::elements
    //--------------------------------------------------------------------------
    // Inlines
    //--------------------------------------------------------------------------
+   namespace detail
+   {
+      template <typename F, std::size_t N>
+      inline typename observer_list<F, N>::entry&
+      observer_list<F, N>::at(std::size_t i)
+      {
+         return (i < N)? _inline[i] : _overflow[i - N];
+      }
+
+      template <typename F, std::size_t N>
+      inline typename observer_list<F, N>::entry const&
+      observer_list<F, N>::at(std::size_t i) const
+      {
+         return (i < N)? _inline[i] : _overflow[i - N];
+      }
+
+      template <typename F, std::size_t N>
+      inline void observer_list<F, N>::append(entry e)
+      {
+         if (_size < N)
+            _inline[_size] = std::move(e);
+         else
+            _overflow.push_back(std::move(e));
+         ++_size;
+      }
+
+      template <typename F, std::size_t N>
+      inline typename observer_list<F, N>::handle
+      observer_list<F, N>::add(F f)
+      {
+         auto id = _next_id++;
+         if (_notifying)
+            _added.push_back(entry{id, std::move(f)});
+         else
+            append(entry{id, std::move(f)});
+         return id;
+      }
+
+      template <typename F, std::size_t N>
+      inline bool observer_list<F, N>::remove(handle h)
+      {
+         if (h == 0)                            // 0 marks removed entries
+            return false;
+
+         std::size_t i = 0;
+         while (i != _size && at(i).id != h)
+            ++i;
+         if (i == _size)
+         {
+            auto j = std::find_if(_added.begin(), _added.end(),
+               [h](auto const& e) { return e.id == h; });
+            if (j == _added.end())
+               return false;
+            _added.erase(j);
+            return true;
+         }
+
+         if (_notifying)
+         {
+            // The observer may be the one running. Leave it in place, but
+            // mark it removed. compact takes it off the list.
+            at(i).id = 0;
+            ++_removed;
+            return true;
+         }
+
+         // Shift the rest down to keep the notification order
+         for (; i+1 < _size; ++i)
+            at(i) = std::move(at(i+1));
+         if (--_size < N)
+            _inline[_size] = entry{};
+         else
+            _overflow.pop_back();
+         return true;
+      }
+
+      template <typename F, std::size_t N>
+      inline void observer_list<F, N>::compact()
+      {
+         // Take the removed entries off the list, keeping the order
+         if (_removed)
+         {
+            std::size_t n = 0;
+            for (std::size_t i = 0; i != _size; ++i)
+            {
+               if (at(i).id == 0)
+                  continue;
+               if (n != i)
+                  at(n) = std::move(at(i));
+               ++n;
+            }
+            for (auto i = n; i < std::min(_size, N); ++i)
+               _inline[i] = entry{};
+            _overflow.resize((n > N)? n - N : 0);
+            _size = n;
+            _removed = 0;
+         }
+
+         // Then the ones added while notifying
+         for (auto& e : _added)
+            append(std::move(e));
+         _added.clear();
+      }
+
+      template <typename F, std::size_t N>
+      template <typename... Args>
+      inline void observer_list<F, N>::notify(Args const&... args)
+      {
+         struct scope
+         {
+            scope(observer_list& list) : list(list) { ++list._notifying; }
+            ~scope() { if (--list._notifying == 0) list.compact(); }
+            observer_list& list;
+         };
+
+         scope s{*this};
+         for (std::size_t i = 0; i != _size; ++i)
+         {
+            if (at(i).id != 0)
+               at(i).f(args...);
+         }
+      }
+
+      inline std::vector<pending_update>& pending_model_updates()
+      {
+         thread_local std::vector<pending_update> pending;
+         return pending;
+      }
+
+      inline int& model_transaction_depth()
+      {
+         thread_local int depth = 0;
+         return depth;
+      }
+
+      inline void commit_model_updates()
+      {
+         // Called with the outermost transaction still in effect, so that
+         // models updated by the observers are appended and notified in
+         // turn. A model is taken off the list before it is notified, so
+         // that it is notified again if an observer updates it later.
+         auto& pending = pending_model_updates();
+         for (std::size_t i = 0; i != pending.size(); ++i)
+         {
+            auto [self, notify] = pending[i];
+            pending[i].first = nullptr;
+            notify(const_cast<void*>(self));
+         }
+         pending.clear();
+      }
+   }
+
 
    /** \brief
     *    Returns a reference to the derived class.
@@ -276,8 +634,27 @@ namespace cycfi::elements
    template <typename T, typename Derived>
    inline void model<T, Derived>::update(param_type val)
    {
-      if (_update)
-         _update(val);
+      if (_observers.empty())
+         return;
+
+      if (detail::model_transaction_depth() > 0)
+      {
+         // Defer until the transaction ends
+         auto& pending = detail::pending_model_updates();
+         auto i = std::find_if(pending.begin(), pending.end(),
+            [this](auto const& p) { return p.first == this; });
+         if (i == pending.end())
+            pending.emplace_back(this, &notify_pending);
+         return;
+      }
+      _observers.notify(val);
+   }
+
+   template <typename T, typename Derived>
+   inline void model<T, Derived>::notify_pending(void* self)
+   {
+      auto& m = *static_cast<model*>(self);
+      m._observers.notify(m.derived().get());
    }
 
    /**
@@ -289,24 +666,32 @@ namespace cycfi::elements
     *
     * \param f
     *    The update function.
+    *
+    * \return
+    *    A handle that may be used to remove the update function via
+    *    `remove_on_update`.
     */
    template <typename T, typename Derived>
-   inline void model<T, Derived>::on_update(update_function f)
+   inline typename model<T, Derived>::observer_handle
+   model<T, Derived>::on_update(update_function f)
    {
-      if (_update)
-      {
-         // Chain call
-         _update =
-            [prev_f = _update, f](value_type val)
-            {
-               prev_f(val);
-               f(val);
-            };
-      }
-      else
-      {
-         _update = f;
-      }
+      return _observers.add(std::move(f));
+   }
+
+   /**
+    * \brief
+    *    Remove an update function previously added via `on_update`.
+    *
+    * \param h
+    *    The handle returned by `on_update`.
+    *
+    * \return
+    *    True if the update function was found and removed.
+    */
+   template <typename T, typename Derived>
+   inline bool model<T, Derived>::remove_on_update(observer_handle h)
+   {
+      return _observers.remove(h);
    }
 
    /**
@@ -411,6 +796,90 @@ namespace cycfi::elements
       _ref = val;
    }
 
+   /**
+    * \brief
+    *    Construct an `atomic_model` given optional initial value `init`
+    *
+    * \param
+    *    init Optional initial value.
+    */
+   template <typename T>
+   inline atomic_model<T>::atomic_model(param_type init)
+   {
+      _slots.fill(init);
+   }
+
+   /**
+    * \brief
+    *    Assign a new value to the model. Unlike `model::operator=`, linked
+    *    UI elements are not updated immediately. The model is delivered
+    *    at the next frame instead, in the view's thread. May be called from
+    *    any thread.
+    *
+    * \param val
+    *    The new value assigned to the model.
+    */
+   template <typename T>
+   inline atomic_model<T>& atomic_model<T>::operator=(param_type val)
+   {
+      set(val);
+      return *this;
+   }
+
+   /**
+    * \brief
+    *    Get the `atomic_model`'s latest value. This must be called in the
+    *    view's thread.
+    */
+   template <typename T>
+   inline typename atomic_model<T>::value_type const&
+   atomic_model<T>::get() const
+   {
+      if (_middle.load(std::memory_order_relaxed) & fresh)
+         _front = _middle.exchange(_front, std::memory_order_acq_rel) & 3;
+      return _slots[_front];
+   }
+
+   /**
+    * \brief
+    *    Set the value of the `atomic_model` to the specified `val` and
+    *    schedule an update of all linked UI elements. May be called from
+    *    any thread, but only by one thread at a time.
+    *
+    * \param val
+    *    The new value to assign to the model.
+    */
+   template <typename T>
+   inline void atomic_model<T>::set(param_type val)
+   {
+      _slots[_back] = val;
+      _back = _middle.exchange(_back | fresh, std::memory_order_acq_rel) & 3;
+      mark_pending();
+   }
+
+   /**
+    * \brief
+    *    Schedule an update of all linked UI elements to the model's latest
+    *    value, at the next frame, in the view's thread. May be called from
+    *    any thread.
+    */
+   template <typename T>
+   inline void atomic_model<T>::update()
+   {
+      mark_pending();
+   }
+
+   template <typename T>
+   inline void atomic_model<T>::deliver()
+   {
+      base_type::update(get());
+   }
+
+   inline void atomic_model_base::mark_pending()
+   {
+      _pending.store(true, std::memory_order_release);
+   }
+
    /**
     * \brief
     *    Construct a `proxy_model` given a reference to the target class
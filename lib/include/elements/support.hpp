@@ -12,14 +12,18 @@
 #include <elements/support/circle.hpp>
 #include <elements/support/color.hpp>
 #include <elements/support/context.hpp>
+#include <elements/support/executor.hpp>
 #include <elements/support/font.hpp>
 #include <elements/support/glyphs.hpp>
+#include <elements/support/glyph_prewarm.hpp>
 #include <elements/support/icon_ids.hpp>
 #include <elements/support/pixmap.hpp>
+#include <elements/support/pixmap_atlas.hpp>
 #include <elements/support/point.hpp>
 #include <elements/support/rect.hpp>
 #include <elements/support/draw_utils.hpp>
 #include <elements/support/text_utils.hpp>
 #include <elements/support/theme.hpp>
+#include <elements/support/tiled_pixmap.hpp>
 
 #endif
@@ -11,11 +11,12 @@
 #include <elements/support/circle.hpp>
 #include <elements/support/pixmap.hpp>
 #include <elements/support/font.hpp>
+#include <elements/support/display_list.hpp>
 #include <infra/filesystem.hpp>
 
+#include <array>
 #include <vector>
-#include <functional>
-#include <stack>
+#include <cstdint>
 #include <cmath>
 #include <cassert>
 
@@ -26,11 +27,14 @@ extern "C"
 
 namespace cycfi { namespace elements
 {
+   class tiled_pixmap;
+
    class canvas
    {
    public:
 
       explicit          canvas(cairo_t& context_);
+                        canvas(cairo_t& context_, display_list& list);
                         canvas(canvas&& rhs);
                         ~canvas();
 
@@ -191,6 +195,9 @@ namespace cycfi { namespace elements
       void              draw(pixmap const& pm, elements::rect dest);
       void              draw(pixmap const& pm, point pos);
 
+      void              draw(tiled_pixmap const& tp, elements::rect src, elements::rect dest);
+      void              draw(tiled_pixmap const& tp, elements::rect dest);
+
       ///////////////////////////////////////////////////////////////////////////////////
       // States
       class state
@@ -217,25 +224,69 @@ namespace cycfi { namespace elements
 
       friend class glyphs;
 
+      void              draw_pixmap(pixmap const& pm, elements::rect src, elements::rect dest, bool pad);
+      display_list::source current_source() const;
+      void              show_text(char const* utf8);
+      bool              record_glyphs(cairo_glyph_t const* glyphs, int num_glyphs);
+
+      // A paint is a trivially copyable descriptor of a fill or stroke
+      // style: a solid color or a cairo pattern. The canvas holds a
+      // reference to its patterns (see _patterns) for as long as a state
+      // refers to them. `transform` maps the pattern's space to user space.
+      struct paint
+      {
+         enum kind_enum : std::uint8_t { none, solid, pattern };
+
+         kind_enum               kind = none;
+         color                   solid_color;
+         cairo_pattern_t*        pattern_ = nullptr;
+         cairo_matrix_t          transform = {1, 0, 0, 1, 0, 0};
+      };
+
       void              apply_fill_style();
       void              apply_stroke_style();
+      void              set_source(paint const& p);
+      void              set_fill_paint(paint p);
+      cairo_pattern_t*  own_pattern(cairo_pattern_t* pat);
+      std::size_t       patterns_mark() const;
+      void              release_pattern(cairo_pattern_t* pat);
+      void              release_patterns(std::size_t mark);
 
       struct canvas_state
       {
-         std::function<void()>   stroke_style;
-         std::function<void()>   fill_style;
+         paint                   stroke_style;
+         paint                   fill_style;
          int                     align          = 0;
 
          enum pattern_state {none_set, stroke_set, fill_set};
          pattern_state           pattern_set = none_set;
+
+         // When recording to a display list: the transform in effect when
+         // the current pattern was set as the cairo source.
+         cairo_matrix_t          source_ctm = {1, 0, 0, 1, 0, 0};
+
+         // Saved states only: the number of _patterns when saved. Patterns
+         // owned after that are released on restore.
+         std::size_t             num_patterns   = 0;
       };
 
-      using state_stack = std::stack<canvas_state>;
+      // Saved states are kept in a fixed capacity inline stack. Deeper
+      // nesting (rare) spills over to the heap.
+      static constexpr std::size_t inline_states = 32;
+
+      using state_stack = std::array<canvas_state, inline_states>;
+      using overflow_stack = std::vector<canvas_state>;
+      using patterns = std::vector<cairo_pattern_t*>;
 
       cairo_t&          _context;
+      cairo_matrix_t    _affine;
       cairo_matrix_t    _inv_affine;
+      display_list*     _display_list = nullptr;
       canvas_state      _state;
       state_stack       _state_stack;
+      std::size_t       _state_depth = 0;
+      overflow_stack    _overflow;
+      patterns          _patterns;
    };
 }}
 
@@ -75,6 +75,15 @@ namespace cycfi { namespace elements
        , enabled{parent_.enabled && element && is_enabled(*element)}
       {}
 
+      // Same as rhs, but drawing to another canvas (e.g. an offscreen cache)
+      context(context const& rhs, elements::canvas& canvas_)
+       : basic_context{rhs.view, canvas_}
+       , element{rhs.element}
+       , parent{rhs.parent}
+       , bounds{rhs.bounds}
+       , enabled{rhs.enabled}
+      {}
+
       context(class view& view_, class canvas& canvas_, element* element_, elements::rect bounds_)
        : basic_context{view_, canvas_}
        , element{element_}
@@ -109,18 +109,18 @@ namespace cycfi { namespace elements
 
    inline void canvas::apply_fill_style()
    {
-      if (_state.pattern_set != _state.fill_set && _state.fill_style)
+      if (_state.pattern_set != _state.fill_set && _state.fill_style.kind != paint::none)
       {
-         _state.fill_style();
+         set_source(_state.fill_style);
          _state.pattern_set = _state.fill_set;
       }
    }
 
    inline void canvas::apply_stroke_style()
    {
-      if (_state.pattern_set != _state.stroke_set && _state.stroke_style)
+      if (_state.pattern_set != _state.stroke_set && _state.stroke_style.kind != paint::none)
       {
-         _state.stroke_style();
+         set_source(_state.stroke_style);
          _state.pattern_set = _state.stroke_set;
       }
    }
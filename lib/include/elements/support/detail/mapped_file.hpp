@@ -0,0 +1,48 @@
+/*=============================================================================
+   Copyright (c) 2016-2024 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_MAPPED_FILE_OCTOBER_18_2026)
+#define ELEMENTS_MAPPED_FILE_OCTOBER_18_2026
+
+#include <infra/filesystem.hpp>
+#include <cstddef>
+#include <cstdint>
+
+namespace cycfi::elements::detail
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // A read-only memory mapping of a whole file. The mapping is empty (and
+   // converts to false) if the file can't be opened or mapped, or is empty.
+   ////////////////////////////////////////////////////////////////////////////
+   class mapped_file
+   {
+   public:
+                           mapped_file() = default;
+      explicit             mapped_file(fs::path const& path);
+                           mapped_file(mapped_file&& rhs) noexcept;
+                           ~mapped_file();
+
+                           mapped_file(mapped_file const&) = delete;
+      mapped_file&         operator=(mapped_file const&) = delete;
+      mapped_file&         operator=(mapped_file&& rhs) noexcept;
+
+      explicit             operator bool() const   { return _data != nullptr; }
+      std::uint8_t const*  data() const            { return static_cast<std::uint8_t const*>(_data); }
+      std::size_t          size() const            { return _size; }
+
+   private:
+
+      void                 close();
+
+      void*                _data = nullptr;
+      std::size_t          _size = 0;
+#if defined(_WIN32)
+      void*                _file = nullptr;        // HANDLE
+      void*                _mapping = nullptr;     // HANDLE
+#endif
+   };
+}
+
+#endif
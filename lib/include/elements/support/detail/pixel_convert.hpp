@@ -0,0 +1,31 @@
+/*=============================================================================
+   Copyright (c) 2016-2024 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_PIXEL_CONVERT_OCTOBER_18_2026)
+#define ELEMENTS_PIXEL_CONVERT_OCTOBER_18_2026
+
+#include <cstddef>
+#include <cstdint>
+
+namespace cycfi::elements::detail
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // The pixel kernel used by the image decoders (see pixmap.cpp). Converts
+   // n straight (non-premultiplied) RGBA pixels from src to premultiplied,
+   // native-endian ARGB32 in dest, swapping red and blue if swap_rb is
+   // true. src and dest may be the same buffer.
+   //
+   // premultiply_pixels uses the SSE2 or NEON code path, if available.
+   // premultiply_pixels_scalar always uses the scalar code path. Both give
+   // identical results.
+   ////////////////////////////////////////////////////////////////////////////
+   void  premultiply_pixels(
+            std::uint8_t const* src, std::uint8_t* dest, std::size_t n, bool swap_rb);
+
+   void  premultiply_pixels_scalar(
+            std::uint8_t const* src, std::uint8_t* dest, std::size_t n, bool swap_rb);
+}
+
+#endif
@@ -0,0 +1,136 @@
+/*=============================================================================
+   Copyright (c) 2016-2024 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_DISPLAY_LIST_OCTOBER_18_2026)
+#define ELEMENTS_DISPLAY_LIST_OCTOBER_18_2026
+
+#include <elements/support/color.hpp>
+#include <elements/support/rect.hpp>
+#include <cairo.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace cycfi::elements
+{
+   class executor;
+
+   /**
+    * \class display_list
+    *
+    * \brief
+    *    A compact list of drawing commands recorded by a `canvas` (see
+    *    `canvas::canvas(cairo_t&, display_list&)`) for deferred replay.
+    *
+    *    While recording, the canvas keeps its transforms, paths and clips
+    *    on its cairo context so queries such as `measure_text` and
+    *    `clip_extent` still work, but fills, strokes, text and images are
+    *    appended to the display list instead of being painted.
+    *
+    *    Paths are stored in the canvas' base space (the space in effect
+    *    when the canvas was created). Commands that are fully clipped out
+    *    are dropped while recording. `optimize()` elides save/restore pairs
+    *    that do not scope a clip, and merges adjacent, non-overlapping fills
+    *    that use the same paint into a single fill.
+    *
+    *    The display list holds references to the cairo patterns, surfaces
+    *    and fonts it uses, so it can be replayed any number of times, on
+    *    any cairo context, including one owned by another thread.
+    *
+    *    `replay(cr, region)` skips the fills, strokes and text that fall
+    *    outside `region` (in base space). `replay(cr, exec)` uses that to
+    *    rasterize the list in horizontal bands, in parallel, on the threads
+    *    of an `executor`. Each band replays only the commands that touch it,
+    *    into its own slice of one image covering the clip extent of `cr`,
+    *    which is then composited onto `cr`.
+    */
+   class display_list
+   {
+   public:
+
+      // The source (paint) of a command. For patterns, `matrix` is the
+      // base-space transform the pattern is locked to.
+      struct source
+      {
+         enum kind_enum : std::uint8_t { solid, pattern };
+
+         kind_enum            kind = solid;
+         color                solid_color;
+         cairo_pattern_t*     pattern_ = nullptr;
+         cairo_matrix_t       matrix = {1, 0, 0, 1, 0, 0};
+      };
+
+                              display_list() = default;
+                              display_list(display_list&& rhs) noexcept;
+                              ~display_list();
+
+                              display_list(display_list const&) = delete;
+      display_list&           operator=(display_list const&) = delete;
+      display_list&           operator=(display_list&& rhs) noexcept;
+
+      void                    clear();
+      bool                    empty() const        { return _commands.empty(); }
+      std::size_t             size() const         { return _commands.size(); }
+
+      void                    optimize();
+      void                    replay(cairo_t& cr) const;
+      void                    replay(cairo_t& cr, rect const& region) const;
+      void                    replay(cairo_t& cr, executor& exec) const;
+
+      // Recording. `base` is the recording canvas' base transform. These
+      // are called by the canvas.
+      void                    save();
+      void                    restore();
+      void                    fill(cairo_t& cr, cairo_matrix_t const& base, source const& src);
+      void                    stroke(cairo_t& cr, cairo_matrix_t const& base, source const& src);
+      void                    clip(cairo_t& cr, cairo_matrix_t const& base);
+      void                    glyphs(
+                                 cairo_t& cr, cairo_matrix_t const& base, source const& src
+                               , cairo_glyph_t const* glyphs, int num_glyphs
+                              );
+
+   private:
+
+      enum op_enum : std::uint8_t
+      {
+         save_op, restore_op, fill_op, stroke_op, clip_op, glyphs_op
+      };
+
+      struct command
+      {
+         op_enum              op;
+         std::uint8_t         fill_rule = CAIRO_FILL_RULE_WINDING;
+         std::uint32_t        source = 0;    // Index to _sources
+         std::uint32_t        first = 0;     // Index to _path_data or _glyphs
+         std::uint32_t        count = 0;
+         float                line_width = 1;
+         cairo_matrix_t       matrix = {1, 0, 0, 1, 0, 0};
+         cairo_scaled_font_t* font = nullptr;
+         rect                 extent = {};   // Base-space bounds
+      };
+
+      void                    replay(cairo_t& cr, rect const* region) const;
+      std::uint32_t           add_source(source const& src);
+      bool                    add_path(cairo_t& cr, command& cmd);
+      void                    set_source(cairo_t& cr, cairo_matrix_t const& base, std::uint32_t index) const;
+      bool                    same_source(std::uint32_t a, std::uint32_t b) const;
+
+      using commands = std::vector<command>;
+      using sources = std::vector<source>;
+      using path_data = std::vector<cairo_path_data_t>;
+      using glyph_data = std::vector<cairo_glyph_t>;
+      using patterns = std::vector<cairo_pattern_t*>;
+      using fonts = std::vector<cairo_scaled_font_t*>;
+
+      commands                _commands;
+      sources                 _sources;
+      path_data               _path_data;
+      glyph_data              _glyphs;
+      patterns                _patterns;
+      fonts                   _fonts;
+   };
+}
+
+#endif
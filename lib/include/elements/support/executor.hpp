@@ -0,0 +1,107 @@
+/*=============================================================================
+   Copyright (c) 2016-2024 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_EXECUTOR_OCTOBER_18_2026)
+#define ELEMENTS_EXECUTOR_OCTOBER_18_2026
+
+#include <infra/support.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cycfi::elements
+{
+   /**
+    * \struct executor_stats
+    *
+    * \brief
+    *    A snapshot of an `executor`'s metrics. Latency is the time tasks
+    *    wait in the queues before they start running.
+    */
+   struct executor_stats
+   {
+      using duration = std::chrono::steady_clock::duration;
+
+      std::size_t             threads = 0;
+      std::size_t             queued = 0;          // Tasks waiting to run
+      std::uint64_t           executed = 0;
+      std::uint64_t           stolen = 0;          // Tasks run by a worker other than the one they were queued to
+      duration                mean_latency = {};
+      duration                max_latency = {};
+   };
+
+   /**
+    * \class executor
+    *
+    * \brief
+    *    A work-stealing thread pool for CPU work (decoding, shaping, data
+    *    crunching, etc.).
+    *
+    *    Each worker has its own queue. Tasks posted from outside the pool
+    *    are distributed round-robin to the workers; tasks posted from a
+    *    worker go to that worker's queue. An idle worker steals from the
+    *    others. Tasks still queued when the executor is destroyed are
+    *    dropped; running tasks are waited for.
+    *
+    *    The library provides a process-wide executor (see
+    *    `shared_executor()`), used by `view::async`, `view::content_async`
+    *    and `async_image`.
+    */
+   class executor : non_copyable
+   {
+   public:
+
+      using task = std::function<void()>;
+
+      explicit                executor(std::size_t num_threads = 0);
+                              ~executor();
+
+      void                    post(task t);
+      std::size_t             num_threads() const { return _threads.size(); }
+      executor_stats          stats() const;
+
+   private:
+
+      using clock = std::chrono::steady_clock;
+
+      struct entry
+      {
+         task                 t;
+         clock::time_point    posted;
+      };
+
+      struct worker_queue;
+      using queue_ptr = std::unique_ptr<worker_queue>;
+
+      void                    run(std::size_t index);
+      bool                    pop(std::size_t index, entry& e);
+
+      std::vector<queue_ptr>  _queues;
+      std::vector<std::thread> _threads;
+
+      std::mutex              _sleep_mutex;
+      std::condition_variable _cv;
+      std::atomic<bool>       _stop{false};
+
+      std::atomic<std::size_t> _next{0};
+      std::atomic<std::size_t> _queued{0};
+      std::atomic<std::uint64_t> _started{0};
+      std::atomic<std::uint64_t> _executed{0};
+      std::atomic<std::uint64_t> _stolen{0};
+      std::atomic<std::int64_t> _total_latency{0};
+      std::atomic<std::int64_t> _max_latency{0};
+   };
+
+   executor&                  shared_executor();
+}
+
+#endif
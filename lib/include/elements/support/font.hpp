@@ -8,6 +8,7 @@
 
 #include <infra/string_view.hpp>
 #include <infra/filesystem.hpp>
+#include <string>
 #include <vector>
 
 extern "C"
@@ -110,10 +111,38 @@ namespace cycfi { namespace elements
    private:
 
       friend class canvas;
+      friend class cached_font;
       cairo_font_face_t*  _handle   = nullptr;
       float               _size     = 12;
    };
 
+   /**
+    * \class cached_font
+    *
+    * \brief
+    *    Holds the `font` resolved from a `font_descr`. The descriptor is
+    *    resolved on first use, and is re-resolved only when its family,
+    *    weight, slant or stretch changes. Elements that draw with a
+    *    descriptor every frame (e.g. labels) hold a `cached_font` to avoid
+    *    resolving the same descriptor over and over.
+    */
+   class cached_font
+   {
+   public:
+
+      font const&          get(font_descr descr);
+      void                 reset() { _valid = false; }
+
+   private:
+
+      std::string          _families;
+      uint8_t              _weight = 0;
+      uint8_t              _slant = 0;
+      uint8_t              _stretch = 0;
+      font                 _font;
+      bool                 _valid = false;
+   };
+
    ////////////////////////////////////////////////////////////////////////////
    // Inlines
    ////////////////////////////////////////////////////////////////////////////
@@ -317,11 +346,43 @@ namespace cycfi { namespace elements
       return _handle;
    }
 
+   inline font const& cached_font::get(font_descr descr)
+   {
+      bool const same_face = _valid
+         && _weight == descr._weight
+         && _slant == descr._slant
+         && _stretch == descr._stretch
+         && _families == descr._families
+         ;
+
+      if (!same_face)
+      {
+         _font = font{descr};
+         _families = descr._families;
+         _weight = descr._weight;
+         _slant = descr._slant;
+         _stretch = descr._stretch;
+         _valid = true;
+      }
+      _font._size = descr._size;
+      return _font;
+   }
+
 #if defined(__APPLE__)
    fs::path get_user_fonts_directory();
 #endif
 
    std::vector<fs::path>& font_paths();
+
+   // Font files are memory mapped and shared by all the faces loaded from
+   // them. Faces that no font object refers to are released, least
+   // recently used first, when the total size of the mapped font files
+   // exceeds this limit (default: 64MB). This is checked when a face is
+   // loaded and when the last font object referring to a face goes away.
+   // Cairo may hold on to a released face (e.g. in its scaled font caches)
+   // for a while before its file is unmapped.
+   void                    font_memory_limit(std::size_t bytes);
+   std::size_t             font_memory_limit();
 }}
 
 #endif
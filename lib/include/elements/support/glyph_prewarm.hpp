@@ -0,0 +1,89 @@
+/*=============================================================================
+   Copyright (c) 2016-2024 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_GLYPH_PREWARM_OCTOBER_18_2026)
+#define ELEMENTS_GLYPH_PREWARM_OCTOBER_18_2026
+
+#include <elements/support/font.hpp>
+#include <infra/support.hpp>
+#include <cairo.h>
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace cycfi::elements
+{
+   /**
+    * \class glyph_prewarmer
+    *
+    * \brief
+    *    Loads fonts, then shapes and rasterizes a set of characters into
+    *    cairo's scaled font caches on a worker thread, so the first frames
+    *    drawn do not have to.
+    *
+    *    Each `font_descr` is warmed at its own size. To warm a font at
+    *    several sizes, supply the font descriptor once per size (e.g.
+    *    `f.size(12)`, `f.size(14)`). `scale` should be the scale the views
+    *    draw with (e.g. the display's hidpi scale).
+    *
+    *    The warmed scaled fonts are kept alive for as long as the
+    *    `glyph_prewarmer` is alive. Create one right after constructing the
+    *    `app`, and keep it alongside the `app`. The destructor cancels any
+    *    pending work and waits for the worker thread to finish.
+    */
+   class glyph_prewarmer : non_copyable
+   {
+   public:
+
+      // Warm the theme fonts: printable ASCII for the text fonts and all
+      // the icons (see icon_ids.hpp) for the icon font.
+                           glyph_prewarmer(float scale = 1);
+
+      // Warm the supplied fonts with the characters in `charset` (UTF-8).
+                           glyph_prewarmer(
+                              std::vector<font_descr> const& fonts
+                            , std::string charset
+                            , float scale = 1
+                           );
+
+                           ~glyph_prewarmer();
+
+      bool                 ready() const;
+      void                 wait();
+
+      static std::string   ascii_charset();
+      static std::string   icons_charset();
+
+   private:
+
+      struct job
+      {
+         std::string       families;
+         font_descr        descr;
+         std::string       charset;
+      };
+
+      using jobs = std::vector<job>;
+      using scaled_fonts = std::vector<cairo_scaled_font_t*>;
+
+      void                 add(font_descr descr, std::string charset);
+      void                 start(float scale);
+      void                 run(float scale);
+
+      jobs                 _jobs;
+      scaled_fonts         _scaled_fonts;
+      std::atomic<bool>    _cancel{false};
+      std::atomic<bool>    _ready{false};
+      std::mutex           _mutex;
+      std::condition_variable _ready_cv;
+      std::thread          _thread;
+   };
+}
+
+#endif
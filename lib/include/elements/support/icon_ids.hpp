@@ -97,6 +97,25 @@ namespace cycfi::elements::icons
       folder_empty                  = 61716,
       folder_open_empty             = 61717,
    };
+
+   // All the icon codepoints above
+   inline constexpr unsigned all[] =
+   {
+      left, right, up, down, left_dir, right_dir, up_dir, down_dir,
+      left_circled, right_circled, up_circled, down_circled, left_open,
+      right_open, up_open, down_open, angle_left, angle_right, angle_up,
+      angle_down, angle_double_left, angle_double_right, angle_double_up,
+      angle_double_down, angle_circled_left, angle_circled_right,
+      angle_circled_up, angle_circled_down, exclamation, block, pencil, pin,
+      resize_vertical, resize_horizontal, move, resize_full_alt, resize_full,
+      resize_small, magnifying_glass, zoom_in, zoom_out, volume_off,
+      volume_down, volume_up, cw, ccw, cycle, level_up, level_down, shuffle,
+      exchange, power, play, stop, pause, record, to_end, to_start,
+      fast_forward, fast_backward, wrench, trash, trash_empty, ok, cancel,
+      plus, minus, cog, doc, docs, lock_open, lock, sliders, floppy,
+      attention, info, error, lightbulb, mixer, hand, question, menu, link,
+      unlink, folder_empty, folder_open_empty
+   };
 }
 
 #endif
@@ -0,0 +1,302 @@
+/*=============================================================================
+   Copyright (c) 2016-2024 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_INSTRUMENT_OCTOBER_18_2026)
+#define ELEMENTS_INSTRUMENT_OCTOBER_18_2026
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace cycfi::elements
+{
+   class element;
+
+   /**
+    * \struct frame_record
+    *
+    * \brief
+    *    Statistics collected for a single `view::draw` or a single view
+    *    event (`click`, `cursor`, `layout`, etc.) dispatched via the view's
+    *    element tree.
+    *
+    *    Phase timings are wall-clock times. Call counts include only the
+    *    calls dispatched by the containers (composites, proxies and the
+    *    view) to their children.
+    */
+   struct frame_record
+   {
+      using clock = std::chrono::steady_clock;
+      using duration = clock::duration;
+
+      enum kind_enum { draw_frame, event };
+
+      kind_enum               kind = draw_frame;
+      char const*             what = "";
+
+      clock::time_point       start = {};
+      duration                total = {};
+      duration                set_limits = {};
+      duration                layout = {};
+      duration                draw = {};
+
+      std::uint32_t           draw_calls = 0;
+      std::uint32_t           limits_calls = 0;
+      std::uint32_t           layout_calls = 0;
+      std::size_t             damage_bytes = 0;
+      std::uint32_t           refresh_posts = 0;
+   };
+
+   /**
+    * \class frame_recorder
+    *
+    * \brief
+    *    A fixed capacity ring buffer of `frame_record`s. The recorder is
+    *    owned by the view when instrumentation is enabled (see
+    *    `ELEMENTS_ENABLE_INSTRUMENTATION`). Records are indexed from the
+    *    oldest (0) to the latest (size()-1).
+    */
+   class frame_recorder
+   {
+   public:
+
+      static constexpr std::size_t capacity = 256;
+
+      void                    begin(frame_record::kind_enum kind, char const* what);
+      void                    end();
+      bool                    active() const { return _depth > 0; }
+
+      std::size_t             size() const { return _size; }
+      bool                    empty() const { return _size == 0; }
+      frame_record const&     operator[](std::size_t i) const;
+      frame_record const&     back() const;
+      void                    clear();
+
+      void                    add_refresh() { ++_pending_refresh; }
+      void                    add_damage(std::size_t bytes);
+
+   private:
+
+      using records = std::array<frame_record, capacity>;
+
+      records                 _records;
+      std::size_t             _head = 0;
+      std::size_t             _size = 0;
+      frame_record            _current;
+      frame_record*           _saved = nullptr;   // The enclosing record (e.g. another view's)
+      int                     _depth = 0;
+      std::atomic<std::uint32_t> _pending_refresh{0};
+   };
+
+   enum class dispatch_kind { draw, limits, layout };
+
+   namespace detail
+   {
+      // The record being collected by the current thread, if any.
+      frame_record*&          active_frame_record();
+
+      class scoped_phase
+      {
+      public:
+                              scoped_phase(frame_record::duration frame_record::*phase);
+                              ~scoped_phase();
+
+                              scoped_phase(scoped_phase const&) = delete;
+         scoped_phase&        operator=(scoped_phase const&) = delete;
+
+      private:
+
+         frame_record::duration frame_record::* _phase;
+         frame_record::clock::time_point _start;
+      };
+
+      class scoped_frame
+      {
+      public:
+                              scoped_frame(frame_recorder& rec, frame_record::kind_enum kind, char const* what);
+                              ~scoped_frame();
+
+                              scoped_frame(scoped_frame const&) = delete;
+         scoped_frame&        operator=(scoped_frame const&) = delete;
+
+      private:
+
+         frame_recorder&      _rec;
+      };
+
+#if defined(ELEMENTS_ENABLE_PROFILER)
+      // Defined in profiler.cpp
+      bool                    profile_begin(dispatch_kind kind, element const& e, std::size_t index);
+      void                    profile_end();
+#endif
+
+      class dispatch_scope
+      {
+      public:
+                              dispatch_scope(dispatch_kind kind, element const& e, std::size_t index = 0);
+#if defined(ELEMENTS_ENABLE_PROFILER)
+                              ~dispatch_scope();
+#endif
+
+                              dispatch_scope(dispatch_scope const&) = delete;
+         dispatch_scope&      operator=(dispatch_scope const&) = delete;
+
+#if defined(ELEMENTS_ENABLE_PROFILER)
+      private:
+
+         bool                 _profiled;
+#endif
+      };
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   // Inlines
+   ////////////////////////////////////////////////////////////////////////////
+   inline frame_record const& frame_recorder::operator[](std::size_t i) const
+   {
+      return _records[(_head + capacity - _size + i) % capacity];
+   }
+
+   inline frame_record const& frame_recorder::back() const
+   {
+      return (*this)[_size-1];
+   }
+
+   inline void frame_recorder::clear()
+   {
+      _head = _size = 0;
+   }
+
+   inline void frame_recorder::add_damage(std::size_t bytes)
+   {
+      if (_depth > 0)
+         _current.damage_bytes += bytes;
+   }
+
+   namespace detail
+   {
+      inline scoped_frame::scoped_frame(frame_recorder& rec, frame_record::kind_enum kind, char const* what)
+       : _rec(rec)
+      {
+         _rec.begin(kind, what);
+      }
+
+      inline scoped_frame::~scoped_frame()
+      {
+         _rec.end();
+      }
+
+      inline scoped_phase::scoped_phase(frame_record::duration frame_record::*phase)
+       : _phase(phase)
+       , _start(frame_record::clock::now())
+      {}
+
+      inline scoped_phase::~scoped_phase()
+      {
+         if (auto rec = active_frame_record())
+            rec->*_phase += frame_record::clock::now() - _start;
+      }
+
+      inline dispatch_scope::dispatch_scope(
+         dispatch_kind kind
+       , [[maybe_unused]] element const& e
+       , [[maybe_unused]] std::size_t index
+      )
+#if defined(ELEMENTS_ENABLE_PROFILER)
+       : _profiled(profile_begin(kind, e, index))
+#endif
+      {
+         if (auto rec = active_frame_record())
+         {
+            switch (kind)
+            {
+               case dispatch_kind::draw: ++rec->draw_calls; break;
+               case dispatch_kind::limits: ++rec->limits_calls; break;
+               case dispatch_kind::layout: ++rec->layout_calls; break;
+            }
+         }
+      }
+
+#if defined(ELEMENTS_ENABLE_PROFILER)
+      inline dispatch_scope::~dispatch_scope()
+      {
+         if (_profiled)
+            profile_end();
+      }
+#endif
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Instrumentation hooks. These expand to nothing unless the library is built
+// with ELEMENTS_ENABLE_INSTRUMENTATION. The dispatch hook is also enabled by
+// ELEMENTS_ENABLE_PROFILER (see profiler.hpp).
+//
+// The dispatch hooks mark a container's call to the `limits`, `layout` or
+// `draw` of its child `e`. `index` is the child's index in the container
+// (0 for proxies). ELEMENTS_INSTRUMENT_DISPATCH(_AT) instruments the rest of
+// the enclosing scope, while ELEMENTS_INSTRUMENT_CALL(_AT) instruments just
+// the call expression given, and yields its result. For example:
+//
+//    auto limits = ELEMENTS_INSTRUMENT_CALL(limits, subject(), subject().limits(ctx));
+////////////////////////////////////////////////////////////////////////////////
+#define ELEMENTS_INSTRUMENT_CAT_I(a, b) a ## b
+#define ELEMENTS_INSTRUMENT_CAT(a, b) ELEMENTS_INSTRUMENT_CAT_I(a, b)
+
+#if defined(ELEMENTS_ENABLE_INSTRUMENTATION)
+
+# define ELEMENTS_INSTRUMENT_FRAME(recorder, kind, what)                       \
+   ::cycfi::elements::detail::scoped_frame                                     \
+      ELEMENTS_INSTRUMENT_CAT(_elements_frame_, __LINE__)                      \
+      {(recorder), ::cycfi::elements::frame_record::kind, (what)}              \
+   /***/
+
+# define ELEMENTS_INSTRUMENT_PHASE(phase)                                      \
+   ::cycfi::elements::detail::scoped_phase                                     \
+      ELEMENTS_INSTRUMENT_CAT(_elements_phase_, __LINE__)                      \
+      {&::cycfi::elements::frame_record::phase}                                \
+   /***/
+
+#else
+
+# define ELEMENTS_INSTRUMENT_FRAME(recorder, kind, what)
+# define ELEMENTS_INSTRUMENT_PHASE(phase)
+
+#endif
+
+#if defined(ELEMENTS_ENABLE_INSTRUMENTATION) || defined(ELEMENTS_ENABLE_PROFILER)
+
+# define ELEMENTS_INSTRUMENT_DISPATCH_AT(kind, e, index)                       \
+   ::cycfi::elements::detail::dispatch_scope                                   \
+      ELEMENTS_INSTRUMENT_CAT(_elements_dispatch_, __LINE__)                   \
+      {::cycfi::elements::dispatch_kind::kind, (e), std::size_t(index)}        \
+   /***/
+
+# define ELEMENTS_INSTRUMENT_CALL_AT(kind, e, index, ...)                      \
+   ([&]() -> decltype(auto)                                                    \
+   {                                                                           \
+      ELEMENTS_INSTRUMENT_DISPATCH_AT(kind, e, index);                         \
+      return __VA_ARGS__;                                                      \
+   }())                                                                        \
+   /***/
+
+#else
+
+# define ELEMENTS_INSTRUMENT_DISPATCH_AT(kind, e, index)
+# define ELEMENTS_INSTRUMENT_CALL_AT(kind, e, index, ...) (__VA_ARGS__)
+
+#endif
+
+#define ELEMENTS_INSTRUMENT_DISPATCH(kind, e)                                  \
+   ELEMENTS_INSTRUMENT_DISPATCH_AT(kind, e, 0)                                 \
+   /***/
+
+#define ELEMENTS_INSTRUMENT_CALL(kind, e, ...)                                 \
+   ELEMENTS_INSTRUMENT_CALL_AT(kind, e, 0, __VA_ARGS__)                        \
+   /***/
+
+#endif
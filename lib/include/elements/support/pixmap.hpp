@@ -41,17 +41,53 @@ namespace cycfi { namespace elements
       extent            size() const;
       float             scale() const;
       void              scale(float val);
+      std::size_t       bytes() const;
 
    private:
 
       friend class canvas;
       friend class pixmap_context;
+      friend class pixmap_atlas;
+      friend class tiled_pixmap;
+      friend class floating_element;
+
+      // Successive box-filtered halvings of the pixmap, generated lazily
+      // (see `level`) for drawing the pixmap at reduced sizes.
+      struct mip_chain;
+
+      cairo_surface_t*  level(float pixel_ratio) const;
+      void              clear_mips();
 
       cairo_surface_t*  _surface;
+      mip_chain*        _mips = nullptr;
+      int               _max_level = 16;        // The deepest mip level used
    };
 
    using pixmap_ptr = std::shared_ptr<pixmap>;
 
+   ////////////////////////////////////////////////////////////////////////////
+   // Pixmap cache
+   //
+   // load_pixmap loads an image file via a process-wide cache, keyed on the
+   // file's canonical path, the scale and the file's modification time. The
+   // cache holds weak references only: identical images share a single
+   // pixmap for as long as one of its users is alive. Being shared, cached
+   // pixmaps should be treated as read-only (do not draw into them or
+   // change their scale). find_pixmap returns the cached pixmap, if any,
+   // without loading it.
+   ////////////////////////////////////////////////////////////////////////////
+   struct pixmap_cache_stats
+   {
+      std::size_t       hits = 0;
+      std::size_t       misses = 0;
+      std::size_t       entries = 0;      // Live cached pixmaps
+      std::size_t       bytes = 0;        // Pixel bytes held by live cached pixmaps
+   };
+
+   pixmap_ptr           load_pixmap(fs::path const& path, float scale = 1);
+   pixmap_ptr           find_pixmap(fs::path const& path, float scale = 1);
+   pixmap_cache_stats   pixmap_cache_statistics();
+
    ////////////////////////////////////////////////////////////////////////////
    // pixmap_context allows drawing into a pixmap
    ////////////////////////////////////////////////////////////////////////////
@@ -60,6 +96,7 @@ namespace cycfi { namespace elements
    public:
 
       explicit          pixmap_context(pixmap& pm)
+                         : _pixmap(&pm)
                         {
                            _context = cairo_create(pm._surface);
                         }
@@ -67,11 +104,15 @@ namespace cycfi { namespace elements
                         ~pixmap_context()
                         {
                            if (_context)
+                           {
                               cairo_destroy(_context);
+                              _pixmap->clear_mips();  // The mips are now stale
+                           }
                         }
 
                         pixmap_context(pixmap_context&& rhs) noexcept
                          : _context(rhs._context)
+                         , _pixmap(rhs._pixmap)
                         {
                            rhs._context = nullptr;
                         }
@@ -82,6 +123,7 @@ namespace cycfi { namespace elements
                         pixmap_context(pixmap_context const&) = delete;
 
       cairo_t*          _context;
+      pixmap*           _pixmap;
    };
 
    ////////////////////////////////////////////////////////////////////////////
@@ -89,8 +131,11 @@ namespace cycfi { namespace elements
    ////////////////////////////////////////////////////////////////////////////
    inline pixmap::pixmap(pixmap&& rhs)
     : _surface(rhs._surface)
+    , _mips(rhs._mips)
+    , _max_level(rhs._max_level)
    {
       rhs._surface = nullptr;
+      rhs._mips = nullptr;
    }
 
    inline pixmap& pixmap::operator=(pixmap&& rhs)
@@ -98,6 +143,8 @@ namespace cycfi { namespace elements
       if (this != &rhs)
       {
         std::swap(_surface, rhs._surface);
+        std::swap(_mips, rhs._mips);
+        std::swap(_max_level, rhs._max_level);
       }
       return *this;
    }
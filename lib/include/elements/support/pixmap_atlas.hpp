@@ -0,0 +1,97 @@
+/*=============================================================================
+   Copyright (c) 2016-2024 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_PIXMAP_ATLAS_OCTOBER_18_2026)
+#define ELEMENTS_PIXMAP_ATLAS_OCTOBER_18_2026
+
+#include <elements/support/pixmap.hpp>
+#include <elements/support/rect.hpp>
+#include <infra/filesystem.hpp>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace cycfi::elements
+{
+   /**
+    * \struct atlas_region
+    *
+    * \brief
+    *    A rectangular region of a pixmap, in the pixmap's logical
+    *    coordinates (the coordinates `pixmap::size()` is measured in).
+    */
+   struct atlas_region
+   {
+      pixmap_ptr           pixmap;
+      rect                 bounds;
+   };
+
+   /**
+    * \class pixmap_atlas
+    *
+    * \brief
+    *    Packs many images (e.g. sprite strips and gizmo images) into a few
+    *    large pixmaps (pages).
+    *
+    *    Add the images with `add`, then call `build` to load and pack them.
+    *    Each image then becomes an `atlas_region` of one of the pages, which
+    *    can be given to `image`, `gizmo`, `hgizmo`, `vgizmo` and
+    *    `basic_sprite`. Images are packed in rows (shelves), tallest first.
+    *    Images of different scales go to different pages. An image larger
+    *    than a page gets a page of its own.
+    *
+    *    Pages are drawn at reduced sizes through their mip levels, each a
+    *    2x2 box filtered halving of the one before. So that filtering never
+    *    mixes in pixels of neighbouring images, images are placed at
+    *    multiples of 2^`mip_levels` pixels, with a gutter of at least that
+    *    many pixels (and at least `padding`) around each, and pages use at
+    *    most `mip_levels` mip levels. The gutters repeat the images' edge
+    *    pixels, so edges are filtered as if the images stood alone.
+    */
+   class pixmap_atlas
+   {
+   public:
+
+      static constexpr int default_page_size = 4096;
+      static constexpr int default_padding = 2;
+      static constexpr int default_mip_levels = 3;
+
+      explicit             pixmap_atlas(
+                              int page_size = default_page_size
+                            , int padding = default_padding
+                            , int mip_levels = default_mip_levels
+                           );
+
+      std::size_t          add(fs::path const& path, float scale = 1);
+      void                 build();
+
+      std::size_t          size() const                           { return _items.size(); }
+      atlas_region const&  operator[](std::size_t i) const;
+      atlas_region const&  get(fs::path const& path, float scale = 1) const;
+
+      std::size_t          num_pages() const                      { return _pages.size(); }
+      pixmap_ptr           page(std::size_t i) const              { return _pages[i]; }
+
+   private:
+
+      struct item
+      {
+         fs::path          path;
+         float             scale;
+         atlas_region      region;
+      };
+
+      using items = std::vector<item>;
+      using pages = std::vector<pixmap_ptr>;
+
+      int                  _page_size;
+      int                  _padding;
+      int                  _mip_levels;
+      items                _items;
+      pages                _pages;
+   };
+}
+
+#endif
@@ -0,0 +1,140 @@
+/*=============================================================================
+   Copyright (c) 2016-2024 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_PROFILER_OCTOBER_18_2026)
+#define ELEMENTS_PROFILER_OCTOBER_18_2026
+
+#include <elements/support/instrument.hpp>
+#include <infra/filesystem.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <tuple>
+#include <typeindex>
+#include <utility>
+#include <vector>
+
+namespace cycfi::elements
+{
+   /**
+    * \class profiler
+    *
+    * \brief
+    *    Aggregates the time spent in the `limits`, `layout` and `draw`
+    *    calls dispatched by the containers, keyed by element type (see
+    *    `element::class_name()`) and by instance path (the chain of
+    *    elements from the view down to the element, each with its index in
+    *    its container).
+    *
+    *    Inclusive time is the time spent in the call including its
+    *    children; exclusive time excludes the children's inclusive time.
+    *
+    *    Each call is also logged as a Chrome `trace_event` "complete" event
+    *    that can be saved via `save_trace` and loaded in Perfetto or
+    *    chrome://tracing.
+    *
+    *    The profiler is compiled in only if the library is built with
+    *    `ELEMENTS_ENABLE_PROFILER`. Profiling is per thread: `get()`
+    *    returns the calling thread's profiler, typically the UI thread's.
+    *    It is disabled until `enable()` is called.
+    */
+   class profiler
+   {
+   public:
+
+      using clock = std::chrono::steady_clock;
+      using duration = clock::duration;
+
+      static constexpr std::size_t num_kinds = 3;
+      static constexpr std::size_t default_max_events = 1 << 20;
+
+      struct stats
+      {
+         std::array<std::uint64_t, num_kinds> calls = {};
+         std::array<duration, num_kinds> inclusive = {};
+         std::array<duration, num_kinds> exclusive = {};
+      };
+
+      struct entry
+      {
+         std::string          name;
+         stats                data;
+      };
+
+                              profiler();
+
+      static profiler&        get();
+
+      void                    enable(bool state = true) { _enabled = state; }
+      bool                    enabled() const           { return _enabled; }
+      void                    max_events(std::size_t n) { _max_events = n; }
+      void                    reset();
+
+      bool                    begin(dispatch_kind kind, element const& e, std::size_t index = 0);
+      void                    end();
+
+      std::vector<entry>      types() const;
+      std::vector<entry>      paths() const;
+
+      void                    write_trace(std::ostream& out) const;
+      bool                    save_trace(fs::path const& path) const;
+
+   private:
+
+      struct node
+      {
+         std::size_t          parent;
+         std::size_t          type;
+         std::string          path;
+         stats                data;
+      };
+
+      struct frame
+      {
+         dispatch_kind        kind;
+         std::size_t          node;
+         clock::time_point    start;
+         duration             children = {};
+      };
+
+      struct event
+      {
+         dispatch_kind        kind;
+         std::size_t          node;
+         clock::time_point    start;
+         duration             dur;
+      };
+
+      static constexpr std::size_t npos = std::size_t(-1);
+
+      std::size_t             type_of(element const& e);
+      std::size_t             node_of(std::size_t parent, element const& e, std::size_t index);
+
+      using type_map = std::map<std::type_index, std::size_t>;
+      // A node is identified by its parent, its index in its parent and
+      // its type. Elements replacing another (e.g. recycled list rows) map
+      // to the same node.
+      using node_key = std::tuple<std::size_t, std::size_t, std::size_t>;
+      using node_map = std::map<node_key, std::size_t>;
+
+      bool                    _enabled = false;
+      std::uint32_t           _thread_id;          // For the trace events
+      std::size_t             _max_events = default_max_events;
+      clock::time_point       _epoch = clock::now();
+
+      type_map                _type_map;
+      std::vector<entry>      _types;
+      node_map                _node_map;
+      std::vector<node>       _nodes;
+      std::vector<frame>      _stack;
+      std::vector<event>      _events;
+   };
+}
+
+#endif
@@ -21,6 +21,7 @@ namespace cycfi { namespace elements
                   [[deprecated("Use measure_text(cnv, text, descr) instead.")]]
    point          measure_text(canvas& cnv, char const* text, font const& font_, float size);
    point          measure_text(canvas& cnv, std::string_view text, font_descr descr);
+   point          measure_text(canvas& cnv, std::string_view text, font const& font_);
    std::string    codepoint_to_utf8(unsigned codepoint);
    bool           is_space(unsigned codepoint);
    bool           is_newline(unsigned codepoint);
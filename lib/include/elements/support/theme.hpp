@@ -7,6 +7,8 @@
 #define ELEMENTS_THEME_APRIL_15_2016
 
 #include <elements/support.hpp>
+#include <cstdint>
+#include <functional>
 
 namespace cycfi::elements
 {
@@ -98,6 +100,22 @@ namespace cycfi::elements
    // Set the global theme
    void set_theme(theme const& thm);
 
+   // The global theme's generation. The generation is incremented every
+   // time the global theme changes (via `set_theme` or `override_theme`).
+   // Caches of theme derived resources can key on the generation to know
+   // when to invalidate their contents.
+   std::uint64_t theme_generation();
+
+   // Register a function that is called, with the new generation, every
+   // time the global theme changes. Returns an id that can be used to
+   // unregister the function. The functions are called from the thread
+   // that changed the theme while holding an internal lock, so they should
+   // not change the theme or (un)register functions themselves.
+   using theme_change_function = std::function<void(std::uint64_t generation)>;
+
+   std::size_t on_theme_change(theme_change_function f);
+   void remove_on_theme_change(std::size_t id);
+
    template <typename T>
    class scoped_theme_override
    {
@@ -109,12 +127,13 @@ namespace cycfi::elements
        , _save(thm.*pmem)
       {
          _thm.*_pmem = val;
+         changed();
       }
 
        scoped_theme_override(scoped_theme_override&& rhs)
        : _thm(rhs._thm)
        , _pmem(rhs._pmem)
-       , _save(rhs._thm.*_pmem)
+       , _save(std::move(rhs._save))
       {
          rhs._pmem = nullptr;
       }
@@ -122,11 +141,16 @@ namespace cycfi::elements
       ~scoped_theme_override()
       {
          if (_pmem)
+         {
             _thm.*_pmem = _save;
+            changed();
+         }
       }
 
    private:
 
+      void        changed();
+
       theme&      _thm;
       T theme::*  _pmem;
       T           _save;
@@ -145,8 +169,16 @@ namespace cycfi::elements
       override_theme(T theme::*pmem, T val);
 
       static theme& _theme();
+      static void _changed();
    };
 
+   template <typename T>
+   inline void scoped_theme_override<T>::changed()
+   {
+      if (&_thm == &global_theme::_theme())
+         global_theme::_changed();
+   }
+
    template <typename T>
    scoped_theme_override<T>
    override_theme(T theme::*pmem, T val)
@@ -0,0 +1,130 @@
+/*=============================================================================
+   Copyright (c) 2016-2024 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_TILED_PIXMAP_OCTOBER_18_2026)
+#define ELEMENTS_TILED_PIXMAP_OCTOBER_18_2026
+
+#include <elements/support/pixmap.hpp>
+#include <elements/support/rect.hpp>
+#include <elements/support/detail/mapped_file.hpp>
+#include <infra/filesystem.hpp>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+namespace cycfi::elements
+{
+   /**
+    * \class tiled_pixmap
+    *
+    * \brief
+    *    A pixmap for very large images, decoded on demand, in tiles.
+    *
+    *    The image file is memory mapped. Tiles are decoded at the
+    *    resolution level (full, half, quarter, etc.) that best fits the
+    *    destination they are drawn to (see `canvas::draw(tiled_pixmap
+    *    const&, rect, rect)`), and are kept in a least recently used cache
+    *    of at most `cache_limit` bytes. Only the tiles intersecting the
+    *    visible part of the destination are decoded and drawn, so memory
+    *    use is bounded by the cache limit and the size of the view, not the
+    *    size of the image.
+    *
+    *    Tiles are never decoded while drawing. `tiles` returns the cached
+    *    tiles, and in place of the missing ones, the cached tiles of a
+    *    coarser level that cover them, if any. The missing tiles, plus an
+    *    overview of the whole image in a single tile, are queued, to be
+    *    decoded by `decode_wanted`, typically in a worker thread.
+    *    `tiled_image` does this on the shared executor and refreshes itself
+    *    as tiles arrive.
+    *
+    *    Tiled decoding is supported for WEBP images (libwebp can decode a
+    *    cropped and scaled region). WEBP is limited to 16383 x 16383 pixels.
+    *    Other image formats are loaded whole, as a regular pixmap, so they
+    *    must fit in memory as a single cairo image (at most 32767 x 32767
+    *    pixels). `failed_to_load_pixmap` is thrown for images that can be
+    *    neither tiled nor loaded whole.
+    */
+   class tiled_pixmap
+   {
+   public:
+
+      static constexpr int default_tile_size = 512;
+      static constexpr std::size_t default_cache_limit = 256 * 1024 * 1024;
+
+      struct tile
+      {
+         pixmap_ptr        pixmap;
+         rect              bounds;     // In the tiled_pixmap's logical coordinates
+         rect              area;       // The part of bounds to draw
+      };
+
+      explicit             tiled_pixmap(
+                              fs::path const& path
+                            , float scale = 1
+                            , std::size_t cache_limit = default_cache_limit
+                            , int tile_size = default_tile_size
+                           );
+
+                           tiled_pixmap(tiled_pixmap const&) = delete;
+      tiled_pixmap&        operator=(tiled_pixmap const&) = delete;
+
+      extent               size() const;
+      float                scale() const                 { return _scale; }
+      bool                 is_tiled() const              { return !_whole; }
+      std::size_t          cache_bytes() const;
+      void                 clear_cache();
+
+      // The cached tiles intersecting `area` (in logical coordinates),
+      // coarser stand-ins first. Missing tiles are queued for decoding.
+      // `pixel_ratio` is the number of device pixels per source (image)
+      // pixel the tiles will be drawn at.
+      std::vector<tile>    tiles(rect area, float pixel_ratio) const;
+
+      // request_decode returns true if there are queued tiles and no
+      // decode_wanted in progress. If so, the caller must call
+      // decode_wanted, which decodes up to `max_tiles` queued tiles.
+      bool                 request_decode() const;
+      void                 decode_wanted(std::size_t max_tiles = std::size_t(-1)) const;
+
+   private:
+
+      using key_type = std::tuple<int, int, int>;  // level, column, row
+
+      struct entry
+      {
+         tile              tile_;
+         std::uint64_t     last_use = 0;
+      };
+
+      using cache_type = std::map<key_type, entry>;
+      using wanted_type = std::vector<key_type>;
+
+      pixmap_ptr           decode(int level, int col, int row, rect& bounds) const;
+      void                 trim(std::uint64_t keep_from) const;
+      void                 want(key_type key) const;
+
+      detail::mapped_file  _file;
+      pixmap_ptr           _whole;     // Non-tiled formats
+      int                  _width = 0;
+      int                  _height = 0;
+      float                _scale;
+      std::size_t          _cache_limit;
+      int                  _tile_size;
+      int                  _overview_level = 0;    // The level where the whole image is one tile
+
+      mutable std::mutex   _mutex;
+      mutable cache_type   _cache;
+      mutable std::size_t  _cache_bytes = 0;
+      mutable std::uint64_t _use_count = 0;
+      mutable wanted_type  _wanted;
+      mutable bool         _decoding = false;
+   };
+}
+
+#endif
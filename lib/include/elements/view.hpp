@@ -15,13 +15,22 @@
 #include <elements/element/layer.hpp>
 #include <elements/element/size.hpp>
 #include <elements/element/indirect.hpp>
+#include <elements/model.hpp>
 #include <elements/support/context.hpp>
+#include <elements/support/instrument.hpp>
+#include <elements/support/executor.hpp>
 
 #include <asio.hpp>
+#include <atomic>
 #include <memory>
 #include <unordered_map>
 #include <chrono>
 #include <map>
+#include <stack>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <type_traits>
 
 namespace cycfi::elements
 {
@@ -29,6 +38,25 @@ namespace cycfi::elements
    class window;
    class idle_tasks;
 
+   /**
+    * \struct animation_tick
+    *
+    * \brief
+    *    Passed to animation functions (see `view::animate`) once per frame.
+    *    All animations ticked in the same frame get the same `now`. The
+    *    animation sets `damage` to the area (in view coordinates) it needs
+    *    redrawn, if any. The damage of all animations is coalesced into a
+    *    single refresh per frame.
+    */
+   struct animation_tick
+   {
+      using clock = std::chrono::steady_clock;
+
+      clock::time_point       now;
+      clock::duration         elapsed;    // Time since the animation's previous tick
+      rect                    damage = {};
+   };
+
    class view : public base_view
    {
    public:
@@ -62,6 +90,12 @@ namespace cycfi::elements
       void                    refresh(element& element, int outward = 0);
       void                    refresh(context const& ctx, int outward = 0);
 
+      // Debugging aid: when enabled, refreshes that cover the whole view are
+      // logged (to std::clog) with the class of the element that asked for
+      // it, if known.
+      void                    debug_refresh(bool state)    { _debug_refresh = state; }
+      bool                    debug_refresh() const        { return _debug_refresh; }
+
       struct undo_redo_task
       {
          std::function<void()> undo;
@@ -90,6 +124,12 @@ namespace cycfi::elements
 
       using layers_vector = std::vector<element_ptr>;
 
+                              template <typename F>
+      std::future<void>       content_async(F make);
+
+                              template <typename F>
+      std::future<void>       add_async(F make, bool focus = true);
+
       void                    add(element_ptr e, bool focus = true);
       void                    remove(element_ptr e);
       void                    move_to_front(element_ptr e);
@@ -106,6 +146,43 @@ namespace cycfi::elements
       using io_context = asio::io_context;
       io_context&             io();
 
+      // Animation functions are called once per frame, at the view's frame
+      // rate, in the view's thread. An animation function returns false
+      // when it is done (idle), and it is then removed. These must be
+      // called in the view's thread.
+      using animation_function = std::function<bool(animation_tick& tick)>;
+      using animation_id = std::size_t;
+
+      animation_id            animate(animation_function f);
+      void                    stop_animation(animation_id id);
+      bool                    is_animating() const    { return !_animations.empty(); }
+      void                    frame_rate(float fps);
+      float                   frame_rate() const;
+
+      // Input coalescing. When enabled (the default), hover and drag
+      // motion events arriving within a frame are merged, keeping the
+      // latest position, and scroll deltas arriving within a frame are
+      // summed. Each is then dispatched at most once per frame (see
+      // frame_rate). An event arriving after a quiet frame is dispatched
+      // immediately. Any other input dispatches the pending event first,
+      // so the order of events is preserved.
+      //
+      // motion_history() holds the positions (and times) of the latest
+      // motion events, including merged ones, for the current hover or
+      // drag gesture, oldest first. Use it, for example, to compute the
+      // velocity of a flick.
+      struct motion_sample
+      {
+         point                pos;
+         std::chrono::steady_clock::time_point time;
+      };
+
+      using motion_history_type = std::vector<motion_sample>;
+
+      void                    coalesce_input(bool state);
+      bool                    coalesce_input() const        { return _coalesce_input; }
+      motion_history_type const& motion_history() const     { return _motion_history; }
+
 
       using steady_timer_ptr = std::shared_ptr<asio::steady_timer>;
 
@@ -115,6 +192,12 @@ namespace cycfi::elements
                               template <typename F>
       void                    post(F f);
 
+                              template <typename Work, typename Completion>
+      void                    async(Work work, Completion completion);
+
+                              template <typename Work, typename Completion>
+      void                    async(std::weak_ptr<void const> guard, Work work, Completion completion);
+
       using tracking = element::tracking;
 
       using track_function = std::function<void(element& e, tracking state)>;
@@ -122,18 +205,91 @@ namespace cycfi::elements
 
       void                    manage_on_tracking(element& e, tracking state);
 
+      // Pending atomic_models tracked by the view are delivered once per
+      // frame (see atomic_model). These must be called in the view's thread.
+      void                    track(atomic_model_base& m);
+      void                    untrack(atomic_model_base& m);
+
       using context_function = element::context_function;
       void                    in_context_do(element& e, context_function f);
 
+      // When enabled, frames are recorded into a display list, optimized,
+      // then replayed to the host's cairo context (see display_list.hpp).
+      void                    use_display_list(bool state) { _use_display_list = state; }
+      bool                    use_display_list() const     { return _use_display_list; }
+      display_list const&     last_display_list() const    { return _display_list; }
+
+      // When enabled, frames are recorded into a display list (as above),
+      // then rasterized in horizontal bands, in parallel, on the shared
+      // executor. Elements still draw (record) in the view's thread.
+      void                    parallel_draw(bool state)    { _parallel_draw = state; }
+      bool                    parallel_draw() const        { return _parallel_draw; }
+
+#if defined(ELEMENTS_ENABLE_INSTRUMENTATION)
+      frame_recorder&         instrumentation()       { return _recorder; }
+      frame_recorder const&   instrumentation() const { return _recorder; }
+#endif
 
    private:
 
+      friend class model_transaction;
+
+      // Shared with worker threads building content for the view.
+      // `self` is cleared (under the lock) when the view is destroyed.
+      struct async_target
+      {
+                              async_target(view* self_) : self{self_} {}
+
+         std::mutex           mutex;
+         view*                self;
+      };
+
+      using async_target_ptr = std::shared_ptr<async_target>;
+
+                              template <typename F, typename G>
+      std::future<void>       build_async(F make, G done);
+
+      void                    swap_content(layers_vector& layers, std::uint64_t generation);
+
+      void                    refresh(rect area, element const* source);
+
+      void                    in_layer_context_do(element& e, context_function f);
+      void                    layout_layer(element& e);
+      void                    refresh_layer(element& e);
+      element*                focus_leaf();
+      void                    refresh_focus(element* prev_focus);
+      void                    log_full_refresh(element const* source);
+
+      void                    begin_refresh_batch();
+      void                    end_refresh_batch();
+      bool                    defer_refresh();
+
       scaled_content          make_scaled_content() { return elements::scale(1.0, link(_content)); }
 
       layer_composite         _content;
       scaled_content          _main_element;
 
       void                    set_limits();
+      void                    draw(canvas& cnv);
+      void                    track_theme();
+      void                    deliver_models();
+      void                    tick_animations(std::chrono::steady_clock::time_point now);
+
+      enum class input_kind { none, cursor, drag, scroll };
+
+      struct pending_input
+      {
+         input_kind           kind = input_kind::none;
+         point                pos;
+         point                dir;
+         mouse_button         btn;
+      };
+
+      bool                    defer_input(pending_input const& e);
+      void                    flush_input();
+      void                    dispatch_drag(mouse_button btn);
+      void                    dispatch_cursor(point p, cursor_tracking status);
+      void                    dispatch_scroll(point dir, point p);
 
       rect                    _current_bounds;
       view_limits             _current_limits = {{0, 0}, { full_extent, full_extent}};
@@ -151,6 +307,53 @@ namespace cycfi::elements
       using tracking_map = std::map<element*, time_point>;
 
       tracking_map            _tracking;
+
+      using models_vector = std::vector<atomic_model_base*>;
+
+      models_vector           _models;
+      time_point              _models_delivered = {};
+      bool                    _delivering_models = false;
+
+      async_target_ptr        _async_target = std::make_shared<async_target>(this);
+      std::uint64_t           _content_generation = 0;
+
+      struct animation
+      {
+         animation_id         id;
+         animation_function   f;
+         time_point           last;
+      };
+
+      using animations_vector = std::vector<animation>;
+      using frame_duration = std::chrono::steady_clock::duration;
+
+      animations_vector       _animations;
+      animations_vector       _added_animations;
+      bool                    _ticking = false;
+      animation_id            _next_animation_id = 1;
+      frame_duration          _frame_interval = std::chrono::microseconds{16667};
+      time_point              _next_frame = {};
+
+      bool                    _coalesce_input = true;
+      pending_input           _pending_input;
+      time_point              _next_input = {};
+      motion_history_type     _motion_history;
+      input_kind              _motion_kind = input_kind::none;
+
+      std::atomic<bool>       _debug_refresh{false};
+      std::atomic<int>        _refresh_batch{0};
+      std::atomic<bool>       _refresh_deferred{false};
+
+      bool                    _use_display_list = false;
+      bool                    _parallel_draw = false;
+      display_list            _display_list;
+
+      std::size_t             _theme_hook = 0;
+      std::atomic<bool>       _theme_changed{false};
+
+#if defined(ELEMENTS_ENABLE_INSTRUMENTATION)
+      frame_recorder          _recorder;
+#endif
    };
 
    ////////////////////////////////////////////////////////////////////////////
@@ -201,6 +404,7 @@ namespace cycfi::elements
 
    inline void view::content(std::initializer_list<element_ptr> list)
    {
+      ++_content_generation;  // Supersedes pending content_async calls
       _content.end_focus();
       _content = list;
       std::reverse(_content.begin(), _content.end());
@@ -220,17 +424,115 @@ namespace cycfi::elements
       {
          return ep;
       }
+
+      inline std::vector<element_ptr> make_layers(std::vector<element_ptr> layers)
+      {
+         return layers;
+      }
+
+      template <typename E>
+      inline std::vector<element_ptr> make_layers(E&& e)
+      {
+         return {add_element(std::forward<E>(e))};
+      }
    }
 
    template <typename... E>
    inline void view::content(E&&... elements)
    {
+      ++_content_generation;  // Supersedes pending content_async calls
       _content.end_focus();
       _content = {detail::add_element(std::forward<E>(elements))...};
       std::reverse(_content.begin(), _content.end());
       set_limits();
    }
 
+   /**
+    * \brief
+    *    Build the view's content in a worker thread, then swap it in, in
+    *    the view's thread, with a single limits and layout pass.
+    *
+    *    `make` is called in the worker thread and returns an element (or
+    *    an element_ptr), or a `layers_vector` ordered like the arguments to
+    *    `content(...)`. Element constructors called by `make` may use the
+    *    thread safe resource caches (fonts, pixmaps, the theme), but must
+    *    not access the view.
+    *
+    *    If the content is set again (synchronously, or by a later
+    *    `content_async`) before the build is done, the build is dropped.
+    *
+    * \return
+    *    A future that is ready when the content is swapped in, or that
+    *    holds the exception thrown by `make`. The future may be discarded.
+    */
+   template <typename F>
+   inline std::future<void> view::content_async(F make)
+   {
+      auto generation = ++_content_generation;
+      return build_async(
+         std::move(make),
+         [this, generation](layers_vector& layers)
+         {
+            swap_content(layers, generation);
+         }
+      );
+   }
+
+   /**
+    * \brief
+    *    Build an element in a worker thread, then add it to the view (see
+    *    `add`) in the view's thread. The requirements on `make` are the
+    *    same as with `content_async`, but it must return a single element.
+    */
+   template <typename F>
+   inline std::future<void> view::add_async(F make, bool focus_top)
+   {
+      return build_async(
+         std::move(make),
+         [this, focus_top](layers_vector& layers)
+         {
+            add(layers.front(), focus_top);
+         }
+      );
+   }
+
+   template <typename F, typename G>
+   inline std::future<void> view::build_async(F make, G done)
+   {
+      auto promise = std::make_shared<std::promise<void>>();
+      auto result = promise->get_future();
+      shared_executor().post(
+         [target = _async_target, make = std::move(make), done, promise]() mutable
+         {
+            layers_vector layers;
+            try
+            {
+               layers = detail::make_layers(make());
+            }
+            catch (...)
+            {
+               promise->set_exception(std::current_exception());
+               return;
+            }
+
+            // Post under the lock so the view can't go away in between. If
+            // it's gone, the promise is broken when the last copy is gone.
+            std::lock_guard<std::mutex> lock(target->mutex);
+            if (target->self)
+            {
+               target->self->post(
+                  [layers, done, promise]() mutable
+                  {
+                     done(layers);
+                     promise->set_value();
+                  }
+               );
+            }
+         }
+      );
+      return result;
+   }
+
    inline void view::add(element_ptr e, bool focus_top)
    {
       // We'll defer this call just to be safe, to give the trigger that
@@ -246,12 +548,17 @@ namespace cycfi::elements
             {
                auto wants_focus = focus_top && e->wants_focus();
                // End the current focus if the new element wants to be the focus.
+               element* prev_focus = nullptr;
                if (wants_focus)
-                  end_focus();
+               {
+                  prev_focus = focus_leaf();
+                  _main_element.end_focus();
+               }
 
-               // Add the new element to the top and lay it out
+               // Add the new element to the top and lay it out. Only the
+               // new layer needs to be laid out and refreshed.
                _content.push_back(e);
-               layout(*e);
+               layout_layer(*e);
 
                // Make the new element the new focus if it wants to.
                if (wants_focus)
@@ -263,7 +570,7 @@ namespace cycfi::elements
                      ;
 
                   _main_element.begin_focus(req);
-                  refresh();
+                  refresh_focus(prev_focus);
                   _is_focus = _main_element.focus();
                }
             }
@@ -290,15 +597,15 @@ namespace cycfi::elements
                   if (_content.focus_index() == ix)
                      relinquish_focus();
 
-                  // Remove the element.
+                  // Refresh the bounds it occupied, then remove it. The
+                  // other layers are not affected, so there's no need to lay
+                  // them out.
+                  refresh_layer(*e);
                   _content.erase(i);
 
-                  // Lay it out
-                  layout();
-
                   // Restore previous focus
                   _main_element.begin_focus(element::focus_request::restore_previous);
-                  refresh();
+                  refresh_focus(nullptr);
                   _is_focus = _main_element.focus();
                }
             }
@@ -322,11 +629,16 @@ namespace cycfi::elements
                auto i = std::find(_content.begin(), _content.end(), e);
                if (i != _content.end())
                {
-                  end_focus();
+                  // Changing the z-order does not change the layers' layout.
+                  // Only the moved layer's bounds need to be redrawn.
+                  auto prev_focus = focus_leaf();
+                  _main_element.end_focus();
                   std::rotate(i, i+1, _content.end());
                   _content.reset();
-                  layout();
-                  begin_focus();
+                  refresh_layer(*e);
+                  if (_is_focus)
+                     _main_element.begin_focus(element::focus_request::restore_previous);
+                  refresh_focus(prev_focus);
                }
             }
          );
@@ -343,11 +655,14 @@ namespace cycfi::elements
                auto i = std::find(_content.begin(), _content.end(), e);
                if (i != _content.end())
                {
-                  end_focus();
+                  auto prev_focus = focus_leaf();
+                  _main_element.end_focus();
                   std::rotate(_content.begin(), i, i+1);
                   _content.reset();
-                  layout();
-                  begin_focus();
+                  refresh_layer(*e);
+                  if (_is_focus)
+                     _main_element.begin_focus(element::focus_request::restore_previous);
+                  refresh_focus(prev_focus);
                }
             }
          );
@@ -393,7 +708,85 @@ namespace cycfi::elements
    template <typename F>
    inline void view::post(F f)
    {
-      _io.post(f);
+      _io.post(std::move(f));
+   }
+
+   /**
+    * \brief
+    *    Run `work` in the shared executor (see `shared_executor()`), then
+    *    call `completion` with its result (if any) in the view's thread.
+    *    The completion is dropped if the view is destroyed before then.
+    *    If `work` throws, the exception is rethrown in the view's thread,
+    *    like exceptions thrown by posted functions. `work` and `completion`
+    *    must be copy constructible.
+    */
+   template <typename Work, typename Completion>
+   inline void view::async(Work work, Completion completion)
+   {
+      async(std::weak_ptr<void const>{_async_target}, std::move(work), std::move(completion));
+   }
+
+   /**
+    * \brief
+    *    Same as `async(work, completion)`, but cancelled when the object
+    *    referred to by `guard` (e.g. an element obtained via
+    *    `shared_from_this()`) goes away: `work` is not started, and
+    *    `completion` is not called, if `guard` has expired by then.
+    */
+   template <typename Work, typename Completion>
+   inline void view::async(std::weak_ptr<void const> guard, Work work, Completion completion)
+   {
+      shared_executor().post(
+         [target = _async_target, guard, work = std::move(work), completion = std::move(completion)]() mutable
+         {
+            if (guard.expired())
+               return;
+
+            // Post f to the view, if it is still around
+            auto post_to_view = [&target](auto f)
+            {
+               std::lock_guard<std::mutex> lock(target->mutex);
+               if (target->self)
+                  target->self->post(std::move(f));
+            };
+
+            using result_type = decltype(work());
+            try
+            {
+               if constexpr (std::is_void_v<result_type>)
+               {
+                  work();
+                  post_to_view(
+                     [guard, completion = std::move(completion)]() mutable
+                     {
+                        if (!guard.expired())
+                           completion();
+                     }
+                  );
+               }
+               else
+               {
+                  auto result = std::make_shared<result_type>(work());
+                  post_to_view(
+                     [guard, result, completion = std::move(completion)]() mutable
+                     {
+                        if (!guard.expired())
+                           completion(std::move(*result));
+                     }
+                  );
+               }
+            }
+            catch (...)
+            {
+               post_to_view(
+                  [error = std::current_exception()]
+                  {
+                     std::rethrow_exception(error);
+                  }
+               );
+            }
+         }
+      );
    }
 }
 
@@ -0,0 +1,133 @@
+/*=============================================================================
+   Copyright (c) 2016-2024 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/element/async_image.hpp>
+#include <elements/support/context.hpp>
+#include <elements/support/theme.hpp>
+#include <elements/view.hpp>
+
+#include <algorithm>
+
+namespace cycfi::elements
+{
+   // The pending load. The state is owned by the element and guards the
+   // load (see view::async): the load is dropped when the element goes
+   // away. `self` follows the element when it is moved.
+   struct async_image::state
+   {
+      async_image*            self = nullptr;
+      fs::path                path;
+      float                   scale = 1;
+      bool                    started = false;
+      bool                    failed = false;
+   };
+
+   async_image::async_image(fs::path path, float scale, extent size)
+    : _pixmap(find_pixmap(path, scale))
+    , _size(size)
+   {
+      if (!_pixmap)
+         _state = std::make_shared<state>(state{this, std::move(path), scale});
+   }
+
+   async_image::async_image(async_image&& rhs)
+    : element(std::move(rhs))
+    , _pixmap(std::move(rhs._pixmap))
+    , _state(std::move(rhs._state))
+    , _size(rhs._size)
+   {
+      if (_state)
+         _state->self = this;
+   }
+
+   bool async_image::has_failed() const
+   {
+      return _state && _state->failed;
+   }
+
+   void async_image::load(context const& ctx)
+   {
+      if (_pixmap || !_state || _state->started)
+         return;
+      _state->started = true;
+
+      auto& view_ = ctx.view;
+      view_.async(
+         _state
+       , [path = _state->path, scale = _state->scale]() -> pixmap_ptr
+         {
+            try
+            {
+               return load_pixmap(path, scale);
+            }
+            catch (std::exception const&)
+            {
+               return {};
+            }
+         }
+
+         // Called in the view's thread, and only if the state (hence the
+         // element) is still around.
+       , [st = _state.get(), &view_](pixmap_ptr pm)
+         {
+            auto self = st->self;
+            if (!pm)
+            {
+               st->failed = true;
+               return;
+            }
+            self->_pixmap = pm;
+            if (self->_size.x == 0 || self->_size.y == 0)
+               view_.layout();
+            else
+               view_.refresh(*self);
+         }
+      );
+   }
+
+   view_limits async_image::limits(basic_context const& /* ctx */) const
+   {
+      if (_size.x != 0 && _size.y != 0)
+         return {_size, _size};
+      if (_pixmap)
+      {
+         auto size_ = _pixmap->size();
+         return {size_, size_};
+      }
+      return {{0, 0}, {0, 0}};
+   }
+
+   void async_image::layout(context const& ctx)
+   {
+      load(ctx);
+   }
+
+   void async_image::draw(context const& ctx)
+   {
+      load(ctx);
+      if (!_pixmap)
+      {
+         draw_placeholder(ctx);
+         return;
+      }
+      // Fit the image in the bounds, keeping its aspect ratio
+      auto size_ = _pixmap->size();
+      if (size_.x <= 0 || size_.y <= 0)
+         return;
+      auto const sc = std::min(ctx.bounds.width() / size_.x, ctx.bounds.height() / size_.y);
+      auto dest = rect{0, 0, size_.x * sc, size_.y * sc};
+      ctx.canvas.draw(*_pixmap, rect{0, 0, size_.x, size_.y}, center(dest, ctx.bounds));
+   }
+
+   void async_image::draw_placeholder(context const& ctx)
+   {
+      auto& cnv = ctx.canvas;
+      auto const& thm = get_theme();
+      cnv.begin_path();
+      cnv.add_rect(ctx.bounds);
+      cnv.fill_style(thm.frame_color.opacity(0.1));
+      cnv.fill();
+   }
+}
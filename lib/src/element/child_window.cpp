@@ -88,9 +88,11 @@ namespace cycfi::elements
          auto fl = find_parent<floating_element*>(ctx);
          if (fl)
          {
+            // Redraw only the area the floating element moved across
             auto p = track_info.movement();
+            auto damage = fl->damage_bounds();
             fl->bounds(fl->bounds().move(p.x, p.y));
-            ctx.view.refresh();
+            ctx.view.refresh(ctx, max(damage, fl->damage_bounds()));
          }
       }
    }
@@ -200,7 +202,7 @@ namespace cycfi::elements
                auto height = b.height();
                auto ob = fl->bounds();
 
-               auto limits = fl->subject().limits(ctx);
+               auto limits = ELEMENTS_INSTRUMENT_CALL(limits, fl->subject(), fl->subject().limits(ctx));
 
                // Constrain width
                if (width < limits.min.x || width > limits.max.x)
@@ -221,8 +223,9 @@ namespace cycfi::elements
                }
                if (b != ob)
                {
+                  auto damage = fl->damage_bounds();
                   fl->bounds(b);
-                  ctx.view.refresh();
+                  ctx.view.refresh(ctx, max(damage, fl->damage_bounds()));
                }
             }
          }
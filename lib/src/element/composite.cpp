@@ -7,6 +7,7 @@
 #include <elements/element/port.hpp>
 #include <elements/element/traversal.hpp>
 #include <elements/support/context.hpp>
+#include <elements/support/instrument.hpp>
 #include <elements/view.hpp>
 
 namespace cycfi::elements
@@ -24,10 +25,10 @@ namespace cycfi::elements
    void composite_base::draw(context const& ctx)
    {
       for_each_visible(ctx,
-         [&ctx](element& e, std::size_t /*ix*/, rect const& bounds)
+         [&ctx](element& e, [[maybe_unused]] std::size_t ix, rect const& bounds)
          {
             context ectx{ctx, &e, bounds};
-            e.draw(ectx);
+            ELEMENTS_INSTRUMENT_CALL_AT(draw, e, ix, e.draw(ectx));
             return false;
          }
       );
@@ -242,7 +242,7 @@ namespace cycfi::elements
 
    view_limits draggable_element::limits(basic_context const& ctx) const
    {
-      auto e_limits = this->subject().limits(ctx);
+      auto e_limits = ELEMENTS_INSTRUMENT_CALL(limits, this->subject(), this->subject().limits(ctx));
       return {{e_limits.min.x, e_limits.min.y}, {full_extent, e_limits.max.y}};
    }
 
@@ -275,7 +275,7 @@ namespace cycfi::elements
 
          view_limits limits(basic_context const& ctx) const override
          {
-            auto r = this->subject().limits(ctx);
+            auto r = ELEMENTS_INSTRUMENT_CALL(limits, this->subject(), this->subject().limits(ctx));
             r.min.x = 32;
             r.max.x += item_offset * _num_boxes;
             r.min.y += item_offset * _num_boxes;
@@ -242,6 +242,22 @@ namespace cycfi::elements
          ctx.view.refresh(ctx, outward);
    }
 
+   /**
+    * \brief
+    *    Notifies the element that something within it requested a refresh.
+    *
+    *    `view::refresh(ctx, ...)` calls this on the element of `ctx` and on
+    *    each of its ancestors, innermost first. Elements that cache their
+    *    rendering (e.g. `floating_element`) use this to know when the cache
+    *    is stale. The default does nothing.
+    *
+    * \param ctx
+    *    The element's context.
+    */
+   void element::damaged(context const& /* ctx */)
+   {
+   }
+
    /**
     * \brief
     *    Executes a function within the given context.
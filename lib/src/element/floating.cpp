@@ -5,19 +5,23 @@
 =============================================================================*/
 #include <elements/element/floating.hpp>
 #include <elements/support/context.hpp>
+#include <elements/support/canvas.hpp>
+#include <elements/view.hpp>
+#include <cairo.h>
+#include <cmath>
 
 namespace cycfi::elements
 {
    view_limits floating_element::limits(basic_context const& ctx) const
    {
-      auto e_limits = this->subject().limits(ctx);
+      auto e_limits = ELEMENTS_INSTRUMENT_CALL(limits, this->subject(), this->subject().limits(ctx));
       return {{e_limits.min.x, e_limits.min.y}, {full_extent, full_extent}};
    }
 
    void floating_element::prepare_subject(context& ctx)
    {
       ctx.bounds = this->bounds();
-      auto  e_limits = this->subject().limits(ctx);
+      auto  e_limits = ELEMENTS_INSTRUMENT_CALL(limits, this->subject(), this->subject().limits(ctx));
       float w = ctx.bounds.width();
       float h = ctx.bounds.height();
 
@@ -37,7 +41,7 @@ namespace cycfi::elements
 
    void floating_element::minimize(context& ctx)
    {
-      auto  e_limits = this->subject().limits(ctx);
+      auto  e_limits = ELEMENTS_INSTRUMENT_CALL(limits, this->subject(), this->subject().limits(ctx));
       auto bounds = this->bounds();
       bounds.width(e_limits.min.x);
       bounds.height(e_limits.min.y);
@@ -46,11 +50,119 @@ namespace cycfi::elements
 
    void floating_element::maximize(context& ctx)
    {
-      auto  e_limits = this->subject().limits(ctx);
+      auto  e_limits = ELEMENTS_INSTRUMENT_CALL(limits, this->subject(), this->subject().limits(ctx));
       auto bounds = this->bounds();
       bounds.width(e_limits.max.x);
       bounds.height(e_limits.max.y);
       this->bounds(bounds);
    }
-}
 
+   ////////////////////////////////////////////////////////////////////////////
+   // Cached surface
+   ////////////////////////////////////////////////////////////////////////////
+   namespace
+   {
+      // Device pixels per user unit, including the target surface's device
+      // scale (e.g. hi-dpi displays)
+      float device_ratio(canvas& cnv)
+      {
+         auto p0 = cnv.user_to_device({0, 0});
+         auto p1 = cnv.user_to_device({1, 1});
+         double scx = 1, scy = 1;
+         cairo_surface_get_device_scale(cairo_get_target(&cnv.cairo_context()), &scx, &scy);
+         return std::max(std::abs(p1.x - p0.x) * scx, std::abs(p1.y - p0.y) * scy);
+      }
+   }
+
+   void floating_element::cache_surface(bool state)
+   {
+      _cache_surface = state;
+      if (!state)
+         _cache.reset();
+      _cache_valid = false;
+   }
+
+   void floating_element::draw(context const& ctx)
+   {
+      if (!_cache_surface)
+      {
+         proxy_base::draw(ctx);
+         return;
+      }
+
+      context sctx {ctx, &subject(), ctx.bounds};
+      prepare_subject(sctx);
+
+      auto& cnv = ctx.canvas;
+      auto ratio = device_ratio(cnv);
+      auto outer = sctx.bounds.inset(-shadow_margin);
+      point size_px = {std::ceil(outer.width() * ratio), std::ceil(outer.height() * ratio)};
+
+      // (Re)allocate the cache when the size or the device ratio changes
+      if (!_cache || ratio != _cache_ratio
+         || cairo_image_surface_get_width(_cache->_surface) != int(size_px.x)
+         || cairo_image_surface_get_height(_cache->_surface) != int(size_px.y))
+      {
+         _cache = std::make_shared<pixmap>(size_px, 1 / ratio);
+         _cache_ratio = ratio;
+         _cache_valid = false;
+      }
+
+      // Render the subject to the cache only when it has changed
+      if (!_cache_valid)
+      {
+         pixmap_context pctx{*_cache};
+         auto cr = pctx.context();
+         cairo_set_operator(cr, CAIRO_OPERATOR_CLEAR);
+         cairo_paint(cr);
+         cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
+
+         canvas cache_cnv{*cr};
+         cache_cnv.translate({-outer.left, -outer.top});
+         context cctx{sctx, cache_cnv};
+         ELEMENTS_INSTRUMENT_CALL(draw, subject(), subject().draw(cctx));
+         _cache_valid = true;
+      }
+      restore_subject(sctx);
+
+      cnv.draw(*_cache, outer.top_left());
+   }
+
+   void floating_element::layout(context const& ctx)
+   {
+      _cache_valid = false;
+      proxy_base::layout(ctx);
+   }
+
+   void floating_element::refresh(context const& ctx, element& element, int outward)
+   {
+      // ctx.bounds is the whole layer. Refresh only our own bounds.
+      if (&element == this && outward == 0)
+      {
+         ctx.view.refresh(ctx, damage_bounds());
+         return;
+      }
+      proxy_base::refresh(ctx, element, outward);
+   }
+
+   void floating_element::damaged(context const& /* ctx */)
+   {
+      // Hold off while dragging: the drag may just be moving us
+      if (_dragging)
+         _drag_damaged = true;
+      else
+         _cache_valid = false;
+   }
+
+   void floating_element::drag(context const& ctx, mouse_button btn)
+   {
+      // Dragging that moves us (see movable) does not change the subject
+      auto before = _bounds;
+      _dragging = true;
+      _drag_damaged = false;
+      proxy_base::drag(ctx, btn);
+      _dragging = false;
+      if (_drag_damaged && _bounds == before)
+         _cache_valid = false;
+   }
+}
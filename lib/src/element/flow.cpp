@@ -21,7 +21,7 @@ namespace cycfi::elements
 
          for (std::size_t i = 0; i != _flowable.size();  ++i)
          {
-            auto el = _flowable.at(i).limits(ctx);
+            auto el = ELEMENTS_INSTRUMENT_CALL_AT(limits, _flowable.at(i), i, _flowable.at(i).limits(ctx));
             clamp_min(limits_.min.x, el.min.x);
          }
       }
@@ -72,7 +72,7 @@ namespace cycfi::elements
 
    float flowable_container::width_of(size_t index, basic_context const& ctx) const
    {
-      return at(index).limits(ctx).min.x;
+      return ELEMENTS_INSTRUMENT_CALL_AT(limits, at(index), index, at(index).limits(ctx)).min.x;
    }
 
    element_ptr flowable_container::make_row(size_t first, size_t last)
@@ -0,0 +1,103 @@
+/*=============================================================================
+   Copyright (c) 2016-2024 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/element/frame_graph.hpp>
+#include <elements/support/context.hpp>
+#include <elements/support/instrument.hpp>
+#include <elements/support/theme.hpp>
+#include <elements/view.hpp>
+#include <cstdio>
+
+namespace cycfi::elements
+{
+   frame_graph_element::frame_graph_element(extent size, float budget_ms)
+    : _size(size)
+    , _budget_ms(budget_ms)
+   {}
+
+   view_limits frame_graph_element::limits(basic_context const& /* ctx */) const
+   {
+      return {{_size.x, _size.y}, {_size.x, _size.y}};
+   }
+
+#if defined(ELEMENTS_ENABLE_INSTRUMENTATION)
+   namespace
+   {
+      float to_ms(frame_record::duration d)
+      {
+         return std::chrono::duration<float, std::milli>(d).count();
+      }
+   }
+
+   void frame_graph_element::draw(context const& ctx)
+   {
+      auto const& rec = ctx.view.instrumentation();
+      auto& cnv = ctx.canvas;
+      auto const& bounds = ctx.bounds;
+
+      cnv.fill_style(rgba(0, 0, 0, 160));
+      cnv.fill_rect(bounds);
+
+      // The vertical scale spans twice the frame budget
+      auto const scale = bounds.height() / (_budget_ms * 2);
+      auto const bar_width = bounds.width() / frame_recorder::capacity;
+
+      auto x = bounds.left;
+      frame_record const* latest = nullptr;
+      for (std::size_t i = 0; i != rec.size(); ++i)
+      {
+         auto const& r = rec[i];
+         if (r.kind != frame_record::draw_frame)
+            continue;
+         latest = &r;
+
+         auto y = bounds.bottom;
+         auto bar = [&](float ms, color c)
+         {
+            auto h = std::min<float>(ms * scale, y - bounds.top);
+            cnv.fill_style(c);
+            cnv.fill_rect({x, y-h, x+bar_width, y});
+            y -= h;
+         };
+
+         auto const limits_ms = to_ms(r.set_limits);
+         auto const layout_ms = to_ms(r.layout);
+         auto const draw_ms = to_ms(r.draw);
+         auto const other_ms = std::max(0.0f, to_ms(r.total) - (limits_ms + layout_ms + draw_ms));
+
+         bar(limits_ms, colors::medium_blue);
+         bar(layout_ms, colors::gold);
+         bar(draw_ms, (to_ms(r.total) > _budget_ms)? colors::red : colors::lime_green);
+         bar(other_ms, colors::gray[60]);
+         x += bar_width;
+      }
+
+      // The frame budget
+      auto const budget_y = bounds.bottom - (_budget_ms * scale);
+      cnv.begin_path();
+      cnv.move_to({bounds.left, budget_y});
+      cnv.line_to({bounds.right, budget_y});
+      cnv.stroke_style(rgba(255, 255, 255, 128));
+      cnv.line_width(1);
+      cnv.stroke();
+
+      if (latest)
+      {
+         char buff[96];
+         std::snprintf(buff, sizeof(buff), "%.2f ms  %u draws  %zu KB",
+            to_ms(latest->total), unsigned(latest->draw_calls), latest->damage_bytes / 1024
+         );
+         cnv.fill_style(get_theme().label_font_color);
+         cnv.font(get_theme().label_font);
+         cnv.text_align(cnv.left | cnv.top);
+         cnv.fill_text(buff, {bounds.left + 4, bounds.top + 4});
+      }
+   }
+#else
+   void frame_graph_element::draw(context const& /* ctx */)
+   {
+   }
+#endif
+}
@@ -5,6 +5,7 @@
 =============================================================================*/
 #include <elements/element/grid.hpp>
 #include <elements/support/context.hpp>
+#include <elements/support/instrument.hpp>
 
 namespace cycfi::elements
 {
@@ -31,7 +32,7 @@ namespace cycfi::elements
          auto factor = 1.0/height;
          prev = y;
 
-         auto el = elem.limits(ctx);
+         auto el = ELEMENTS_INSTRUMENT_CALL_AT(limits, elem, i, elem.limits(ctx));
          auto elem_desired_total_min = el.min.y * factor;
          if (desired_total_min < elem_desired_total_min)
             desired_total_min = elem_desired_total_min;
@@ -64,7 +65,7 @@ namespace cycfi::elements
          auto y = grid_coord(gi++) * total_height;
          auto height = y - prev;
          rect ebounds = {left, prev, right, prev+height};
-         elem.layout(context{ctx, &elem, ebounds});
+         ELEMENTS_INSTRUMENT_CALL_AT(layout, elem, i, elem.layout(context{ctx, &elem, ebounds}));
          _positions[i] = prev;
          prev = y;
       }
@@ -104,7 +105,7 @@ namespace cycfi::elements
          auto factor = 1.0/width;
          prev = x;
 
-         auto el = elem.limits(ctx);
+         auto el = ELEMENTS_INSTRUMENT_CALL_AT(limits, elem, i, elem.limits(ctx));
          auto elem_desired_total_min = el.min.x * factor;
          if (desired_total_min < elem_desired_total_min)
             desired_total_min = elem_desired_total_min;
@@ -137,7 +138,7 @@ namespace cycfi::elements
          auto x = grid_coord(gi++) * total_width;
          auto width = x - prev;
          rect ebounds = {prev, top, prev+width, bottom};
-         elem.layout(context{ctx, &elem, ebounds});
+         ELEMENTS_INSTRUMENT_CALL_AT(layout, elem, i, elem.layout(context{ctx, &elem, ebounds}));
          _positions[i] = prev;
          prev = x;
       }
@@ -6,6 +6,7 @@
 #include <elements/element/image.hpp>
 #include <elements/support.hpp>
 #include <elements/support/context.hpp>
+#include <elements/view.hpp>
 #include <algorithm>
 
 namespace cycfi::elements
@@ -14,14 +15,14 @@ namespace cycfi::elements
    // image implementation
    ////////////////////////////////////////////////////////////////////////////
    image::image(fs::path const& path, float scale)
-    : _pixmap(std::make_shared<elements::pixmap>(path, scale))
+    : _pixmap(load_pixmap(path, scale))
    {
       if (!_pixmap)
          throw std::runtime_error{"Error: Invalid image."};
    }
 
    image::image(fs::path const& path, fit_enum)
-    : _pixmap(std::make_shared<elements::pixmap>(path, 1.0f))
+    : _pixmap(load_pixmap(path, 1.0f))
     , _fit{true}
    {
       if (!_pixmap)
@@ -35,9 +36,25 @@ namespace cycfi::elements
          throw std::runtime_error{"Error: Invalid image."};
    }
 
+   image::image(atlas_region const& region)
+    : _pixmap(region.pixmap)
+    , _region(region.bounds)
+   {
+      if (!_pixmap)
+         throw std::runtime_error{"Error: Invalid image."};
+   }
+
+   rect image::image_bounds() const
+   {
+      if (!_region.is_empty())
+         return _region;
+      auto s = _pixmap->size();
+      return {0, 0, s.x, s.y};
+   }
+
    point image::size() const
    {
-      return _pixmap->size();
+      return image_bounds().size();
 
       auto sz = _pixmap->size();
       if (!_fit)
@@ -49,8 +66,7 @@ namespace cycfi::elements
    rect image::source_rect(context const& ctx) const
    {
       unused(ctx);
-      auto s = _pixmap->size();
-      return {0, 0, s.x, s.y};
+      return image_bounds();
    }
 
    view_limits image::limits(basic_context const& ctx) const
@@ -58,7 +74,7 @@ namespace cycfi::elements
       unused(ctx);
       if (!_fit)
       {
-         auto size_ = _pixmap->size();
+         auto size_ = image_bounds().size();
          return {{size_.x, size_.y}, {size_.x, size_.y}};
       }
       else // fit
@@ -89,11 +105,53 @@ namespace cycfi::elements
 
    void image::set_image(fs::path const& path, float scale)
    {
-      _pixmap = std::make_shared<elements::pixmap>(path, scale);
+      _pixmap = load_pixmap(path, scale);
+      _region = {};
+      if (!_pixmap)
+         throw std::runtime_error{"Error: Invalid image."};
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   // tiled_image implementation
+   ////////////////////////////////////////////////////////////////////////////
+   tiled_image::tiled_image(fs::path const& path, float scale)
+    : _pixmap(std::make_shared<tiled_pixmap>(path, scale))
+   {
+   }
+
+   tiled_image::tiled_image(tiled_pixmap_ptr pixmap_)
+    : _pixmap(pixmap_)
+   {
       if (!_pixmap)
          throw std::runtime_error{"Error: Invalid image."};
    }
 
+   view_limits tiled_image::limits(basic_context const& /* ctx */) const
+   {
+      auto size_ = _pixmap->size();
+      return {{size_.x, size_.y}, {size_.x, size_.y}};
+   }
+
+   void tiled_image::draw(context const& ctx)
+   {
+      ctx.canvas.draw(*_pixmap, ctx.bounds);
+
+      // Decode some of the missing tiles in the background, then refresh
+      // the visible part of the image. Drawing again requests the rest.
+      constexpr std::size_t decode_batch = 4;
+      if (_pixmap->request_decode())
+      {
+         auto vis = intersection(ctx.bounds, ctx.canvas.clip_extent());
+         auto tl = ctx.canvas.user_to_device(vis.top_left());
+         auto br = ctx.canvas.user_to_device(vis.bottom_right());
+         ctx.view.async(
+            _pixmap
+          , [pm = _pixmap]{ pm->decode_wanted(decode_batch); }
+          , [&view = ctx.view, area = rect{tl.x, tl.y, br.x, br.y}]{ view.refresh(area); }
+         );
+      }
+   }
+
    ////////////////////////////////////////////////////////////////////////////
    // gizmo implementation
    ////////////////////////////////////////////////////////////////////////////
@@ -155,6 +213,10 @@ namespace cycfi::elements
     : image(pixmap_)
    {}
 
+   gizmo::gizmo(atlas_region const& region)
+    : image(region)
+   {}
+
    view_limits gizmo::limits(basic_context const& /* ctx */) const
    {
       auto size_ = size();
@@ -165,8 +227,7 @@ namespace cycfi::elements
    {
       rect  src[9];
       rect  dest[9];
-      auto  size_ = size();
-      rect  src_bounds{0, 0, size_.x, size_.y};
+      auto  src_bounds = image_bounds();
 
       gizmo_parts(src_bounds, src_bounds, src);
       gizmo_parts(src_bounds, ctx.bounds, dest);
@@ -183,6 +244,10 @@ namespace cycfi::elements
     : image(pixmap_)
    {}
 
+   hgizmo::hgizmo(atlas_region const& region)
+    : image(region)
+   {}
+
    view_limits hgizmo::limits(basic_context const& /* ctx */) const
    {
       auto size_ = size();
@@ -193,8 +258,7 @@ namespace cycfi::elements
    {
       rect  src[3];
       rect  dest[3];
-      auto  size_ = size();
-      rect  src_bounds{0, 0, size_.x, size_.y};
+      auto  src_bounds = image_bounds();
 
       hgizmo_parts(src_bounds, src_bounds, src);
       hgizmo_parts(src_bounds, ctx.bounds, dest);
@@ -211,6 +275,10 @@ namespace cycfi::elements
     : image(pixmap_)
    {}
 
+   vgizmo::vgizmo(atlas_region const& region)
+    : image(region)
+   {}
+
    view_limits vgizmo::limits(basic_context const& /* ctx */) const
    {
       auto size_ = size();
@@ -221,8 +289,7 @@ namespace cycfi::elements
    {
       rect  src[3];
       rect  dest[3];
-      auto  size_ = size();
-      rect  src_bounds{0, 0, size_.x, size_.y};
+      auto  src_bounds = image_bounds();
 
       vgizmo_parts(src_bounds, src_bounds, src);
       vgizmo_parts(src_bounds, ctx.bounds, dest);
@@ -237,15 +304,21 @@ namespace cycfi::elements
     , _height(height)
    {}
 
+   basic_sprite::basic_sprite(atlas_region const& region, float height)
+    : image(region)
+    , _index(0)
+    , _height(height)
+   {}
+
    view_limits basic_sprite::limits(basic_context const& /* ctx */) const
    {
-      auto width = pixmap().size().x;
+      auto width = image_bounds().width();
       return {{width, _height}, {width, _height}};
    }
 
    std::size_t basic_sprite::num_frames() const
    {
-      return pixmap().size().y / _height;
+      return image_bounds().height() / _height;
    }
 
    void basic_sprite::index(std::size_t index_)
@@ -256,12 +329,12 @@ namespace cycfi::elements
 
    point basic_sprite::size() const
    {
-      return {pixmap().size().x, _height};
+      return {image_bounds().width(), _height};
    }
 
    rect basic_sprite::source_rect(context const& /* ctx */) const
    {
-      auto width = pixmap().size().x;
-      return rect{0, _height * _index, width, _height * (_index + 1)};
+      auto b = image_bounds();
+      return rect{b.left, b.top + _height * _index, b.right, b.top + _height * (_index + 1)};
    }
 }
@@ -6,6 +6,7 @@
 #include <elements/element/layer.hpp>
 #include <elements/view.hpp>
 #include <elements/support/context.hpp>
+#include <elements/support/instrument.hpp>
 
 namespace cycfi::elements
 {
@@ -17,7 +18,7 @@ namespace cycfi::elements
       view_limits limits{{0.0, 0.0}, {full_extent, full_extent}};
       for (std::size_t ix = 0; ix != size();  ++ix)
       {
-         auto el = at(ix).limits(ctx);
+         auto el = ELEMENTS_INSTRUMENT_CALL_AT(limits, at(ix), ix, at(ix).limits(ctx));
 
          clamp_min(limits.min.x, el.min.x);
          clamp_min(limits.min.y, el.min.y);
@@ -36,7 +37,7 @@ namespace cycfi::elements
       for (std::size_t ix = 0; ix != size(); ++ix)
       {
          auto& e = at(ix);
-         e.layout(context{ctx, &e, bounds_of(ctx, ix)});
+         ELEMENTS_INSTRUMENT_CALL_AT(layout, e, ix, e.layout(context{ctx, &e, bounds_of(ctx, ix)}));
       }
    }
 
@@ -79,7 +80,7 @@ namespace cycfi::elements
       auto top = ctx.bounds.top;
       auto width = ctx.bounds.width();
       auto height = ctx.bounds.height();
-      auto  limits = at(index).limits(ctx);
+      auto  limits = ELEMENTS_INSTRUMENT_CALL_AT(limits, at(index), index, at(index).limits(ctx));
 
       clamp_min(width, limits.min.x);
       clamp_max(width, limits.max.x);
@@ -99,7 +100,7 @@ namespace cycfi::elements
       {
          auto& elem = at(_selected_index);
          context ectx{ctx, &elem, bounds};
-         elem.draw(ectx);
+         ELEMENTS_INSTRUMENT_CALL_AT(draw, elem, _selected_index, elem.draw(ectx));
       }
    }
 
@@ -158,15 +158,15 @@ namespace cycfi::elements
             {
                cell.elem_ptr = at(it-_cells.begin()).shared_from_this();
                rctx.enabled = rctx.parent->enabled && cell.elem_ptr->is_enabled();
-               cell.elem_ptr->layout(rctx);
+               ELEMENTS_INSTRUMENT_CALL_AT(layout, *cell.elem_ptr, it - _cells.begin(), cell.elem_ptr->layout(rctx));
                cell.layout_id = _layout_id;
             }
             else if (cell.layout_id != _layout_id)
             {
-               cell.elem_ptr->layout(rctx);
+               ELEMENTS_INSTRUMENT_CALL_AT(layout, *cell.elem_ptr, it - _cells.begin(), cell.elem_ptr->layout(rctx));
                cell.layout_id = _layout_id;
             }
-            cell.elem_ptr->draw(rctx);
+            ELEMENTS_INSTRUMENT_CALL_AT(draw, *cell.elem_ptr, it - _cells.begin(), cell.elem_ptr->draw(rctx));
          }
 
          if (get_main_axis_start(rctx.bounds) > main_axis_clip_end)
@@ -313,17 +313,25 @@ namespace cycfi::elements
       bool hit = ctx.bounds.includes(p);
       if (status == cursor_tracking::leaving || hit)
       {
+         // Unselect the other items, refreshing only those that change
          auto [c, cctx] = find_composite(ctx);
          if (c)
          {
             for (std::size_t i = 0; i != c->size(); ++i)
             {
-               if (auto e = find_element<selectable*>(&c->at(i)))
+               auto e = find_element<selectable*>(&c->at(i));
+               if (e && e != static_cast<selectable*>(this) && e->is_selected())
+               {
                   e->select(false);
+                  cctx->view.refresh(*cctx, c->bounds_of(*cctx, i));
+               }
             }
-            cctx->view.refresh(*cctx);
          }
-         select(hit);
+         if (hit != is_selected())
+         {
+            select(hit);
+            ctx.view.refresh(ctx);
+         }
       }
       proxy_base::cursor(ctx, p, status);
       return hit;
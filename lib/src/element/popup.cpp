@@ -15,9 +15,11 @@ namespace cycfi::elements
 
    bool basic_popup_element::cursor(context const& ctx, point p, cursor_tracking status)
    {
-      bool hit = proxy_base::hit_test(ctx, p, false, true);
-      if (status == cursor_tracking::leaving || hit)
-         ctx.view.refresh();
+      // The items track their own hover state and refresh only themselves
+      // (see basic_menu_item_element::cursor). We refresh just the popup
+      // when the cursor leaves it.
+      if (status == cursor_tracking::leaving)
+         ctx.view.refresh(ctx, damage_bounds());
       bool r = proxy_base::cursor(ctx, p, status);
       on_cursor(p, status);
       return r;
@@ -30,14 +32,16 @@ namespace cycfi::elements
 
    void basic_popup_element::open(view& view_)
    {
+      // The view refreshes our bounds after laying us out (see view::add
+      // and floating_element::refresh)
       view_.add(shared_from_this(), true);
-      view_.refresh();
    }
 
    void basic_popup_element::close(view& view_)
    {
+      // Refresh our bounds before we're gone
+      view_.refresh(*this);
       view_.remove(shared_from_this());
-      view_.refresh();
    }
 
    element* basic_popup_menu_element::hit_test(context const& ctx, point p, bool leaf, bool control)
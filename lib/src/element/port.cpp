@@ -50,13 +50,13 @@ namespace cycfi::elements
 
    view_limits port_element::limits(basic_context const& ctx) const
    {
-      view_limits e_limits = subject().limits(ctx);
+      view_limits e_limits = ELEMENTS_INSTRUMENT_CALL(limits, subject(), subject().limits(ctx));
       return {{min_port_size, min_port_size}, e_limits.max};
    }
 
    void port_element::prepare_subject(context& ctx)
    {
-      view_limits    e_limits          = subject().limits(ctx);
+      view_limits    e_limits          = ELEMENTS_INSTRUMENT_CALL(limits, subject(), subject().limits(ctx));
       double         elem_width        = e_limits.min.x;
       double         elem_height       = e_limits.min.y;
       double         available_width   = ctx.parent->bounds.width();
@@ -67,43 +67,43 @@ namespace cycfi::elements
       ctx.bounds.top -= (elem_height - available_height) * _valign;
       ctx.bounds.height(elem_height);
 
-      subject().layout(ctx);
+      ELEMENTS_INSTRUMENT_CALL(layout, subject(), subject().layout(ctx));
    }
 
    view_limits vport_element::limits(basic_context const& ctx) const
    {
-      view_limits e_limits = subject().limits(ctx);
+      view_limits e_limits = ELEMENTS_INSTRUMENT_CALL(limits, subject(), subject().limits(ctx));
       return {{e_limits.min.x, min_port_size}, e_limits.max};
    }
 
    void vport_element::prepare_subject(context& ctx)
    {
-      view_limits e_limits = subject().limits(ctx);
+      view_limits e_limits = ELEMENTS_INSTRUMENT_CALL(limits, subject(), subject().limits(ctx));
       double elem_height = e_limits.min.y;
       double available_height = ctx.parent->bounds.height();
 
       ctx.bounds.top -= (elem_height - available_height) * _valign;
       ctx.bounds.height(elem_height);
 
-      subject().layout(ctx);
+      ELEMENTS_INSTRUMENT_CALL(layout, subject(), subject().layout(ctx));
    }
 
    view_limits hport_element::limits(basic_context const& ctx) const
    {
-      view_limits e_limits = subject().limits(ctx);
+      view_limits e_limits = ELEMENTS_INSTRUMENT_CALL(limits, subject(), subject().limits(ctx));
       return {{min_port_size, e_limits.min.y}, e_limits.max};
    }
 
    void hport_element::prepare_subject(context& ctx)
    {
-      view_limits e_limits = subject().limits(ctx);
+      view_limits e_limits = ELEMENTS_INSTRUMENT_CALL(limits, subject(), subject().limits(ctx));
       double elem_width = e_limits.min.x;
       double available_width = ctx.parent->bounds.width();
 
       ctx.bounds.left -= (elem_width - available_width) * _halign;
       ctx.bounds.width(elem_width);
 
-      subject().layout(ctx);
+      ELEMENTS_INSTRUMENT_CALL(layout, subject(), subject().layout(ctx));
    }
 
    /**
@@ -265,7 +265,7 @@ namespace cycfi::elements
 
    view_limits scroller_base::limits(basic_context const& ctx) const
    {
-      view_limits e_limits = subject().limits(ctx);
+      view_limits e_limits = ELEMENTS_INSTRUMENT_CALL(limits, subject(), subject().limits(ctx));
       auto min_x = allow_hscroll() ? min_port_size : e_limits.min.x;
       auto min_y = allow_vscroll() ? min_port_size : e_limits.min.y;
       auto max_x = std::max(min_x, e_limits.max.x);
@@ -275,7 +275,7 @@ namespace cycfi::elements
 
    void scroller_base::prepare_subject(context& ctx)
    {
-      view_limits e_limits = subject().limits(ctx);
+      view_limits e_limits = ELEMENTS_INSTRUMENT_CALL(limits, subject(), subject().limits(ctx));
 
       if (allow_vscroll())
       {
@@ -300,7 +300,7 @@ namespace cycfi::elements
             ctx.bounds.left -= (elem_width - available_width) * halign();
          ctx.bounds.width(elem_width);
       }
-      subject().layout(ctx);
+      ELEMENTS_INSTRUMENT_CALL(layout, subject(), subject().layout(ctx));
    }
 
    element* scroller_base::hit_test(context const& ctx, point p, bool leaf, bool control)
@@ -316,7 +316,7 @@ namespace cycfi::elements
    scroller_base::get_scrollbar_bounds(context const& ctx)
    {
       scrollbar_bounds r;
-      view_limits e_limits = subject().limits(ctx);
+      view_limits e_limits = ELEMENTS_INSTRUMENT_CALL(limits, subject(), subject().limits(ctx));
       theme const& thm = get_theme();
 
       r.has_h = allow_hscroll() &&
@@ -361,7 +361,7 @@ namespace cycfi::elements
       if (has_scrollbars())
       {
          scrollbar_bounds sb = get_scrollbar_bounds(ctx);
-         view_limits e_limits = subject().limits(ctx);
+         view_limits e_limits = ELEMENTS_INSTRUMENT_CALL(limits, subject(), subject().limits(ctx));
          point mp = ctx.cursor_pos();
 
          if (sb.has_v)
@@ -374,7 +374,7 @@ namespace cycfi::elements
 
    bool scroller_base::scroll(context const& ctx, point dir, point p)
    {
-      view_limits e_limits = subject().limits(ctx);
+      view_limits e_limits = ELEMENTS_INSTRUMENT_CALL(limits, subject(), subject().limits(ctx));
       bool redraw = false;
 
       if (allow_hscroll())
@@ -467,7 +467,7 @@ namespace cycfi::elements
          return false;
 
       scrollbar_bounds  sb = get_scrollbar_bounds(ctx);
-      view_limits       e_limits = subject().limits(ctx);
+      view_limits       e_limits = ELEMENTS_INSTRUMENT_CALL(limits, subject(), subject().limits(ctx));
 
       auto valign_ = [&](double align)
       {
@@ -657,7 +657,7 @@ namespace cycfi::elements
             case key_code::page_up:
             case key_code::page_down:
             {
-               view_limits e_limits = subject().limits(ctx);
+               view_limits e_limits = ELEMENTS_INSTRUMENT_CALL(limits, subject(), subject().limits(ctx));
                scrollbar_bounds sb = get_scrollbar_bounds(ctx);
                rect b = scroll_bar_position(
                   ctx, {valign(), e_limits.min.y, sb.vscroll_bounds});
@@ -5,13 +5,14 @@
 =============================================================================*/
 #include <elements/element/proxy.hpp>
 #include <elements/support/context.hpp>
+#include <elements/support/instrument.hpp>
 #include <elements/view.hpp>
 
 namespace cycfi::elements
 {
    view_limits proxy_base::limits(basic_context const& ctx) const
    {
-      return subject().limits(ctx);
+      return ELEMENTS_INSTRUMENT_CALL(limits, subject(), subject().limits(ctx));
    }
 
    view_stretch proxy_base::stretch() const
@@ -37,7 +38,7 @@ namespace cycfi::elements
    {
       context sctx {ctx, &subject(), ctx.bounds};
       prepare_subject(sctx);
-      subject().draw(sctx);
+      ELEMENTS_INSTRUMENT_CALL(draw, subject(), subject().draw(sctx));
       restore_subject(sctx);
    }
 
@@ -45,7 +46,7 @@ namespace cycfi::elements
    {
       context sctx {ctx, &subject(), ctx.bounds};
       prepare_subject(sctx);
-      subject().layout(sctx);
+      ELEMENTS_INSTRUMENT_CALL(layout, subject(), subject().layout(sctx));
       restore_subject(sctx);
    }
 
@@ -13,9 +13,9 @@ namespace cycfi::elements
 {
    view_limits range_slider_base::limits(basic_context const& ctx) const
    {
-      auto  limits_ = track().limits(ctx);
-      auto  tmb_limit1 = thumb().first.get().limits(ctx);
-      auto  tmb_limit2 = thumb().second.get().limits(ctx);
+      auto  limits_ = ELEMENTS_INSTRUMENT_CALL(limits, track(), track().limits(ctx));
+      auto  tmb_limit1 = ELEMENTS_INSTRUMENT_CALL_AT(limits, thumb().first.get(), 1, thumb().first.get().limits(ctx));
+      auto  tmb_limit2 = ELEMENTS_INSTRUMENT_CALL_AT(limits, thumb().second.get(), 2, thumb().second.get().limits(ctx));
 
       // We multiply thumb min limits by 2 so that there is always some space to move it.
       if (_is_horiz = limits_.max.x > limits_.max.y; _is_horiz)
@@ -51,19 +51,19 @@ namespace cycfi::elements
       {
          context sctx {ctx, &track(), ctx.bounds};
          sctx.bounds = track_bounds(sctx);
-         track().layout(sctx);
+         ELEMENTS_INSTRUMENT_CALL(layout, track(), track().layout(sctx));
       }
       auto bounds = thumb_bounds(ctx);
       auto thumbs = thumb();
       {
          context sctx {ctx, &thumbs.first.get(), ctx.bounds};
          sctx.bounds = bounds.first;
-         thumbs.first.get().layout(sctx);
+         ELEMENTS_INSTRUMENT_CALL_AT(layout, thumbs.first.get(), 1, thumbs.first.get().layout(sctx));
       }
       {
          context sctx {ctx, &thumbs.second.get(), ctx.bounds};
          sctx.bounds = bounds.second;
-         thumbs.second.get().layout(sctx);
+         ELEMENTS_INSTRUMENT_CALL_AT(layout, thumbs.second.get(), 2, thumbs.second.get().layout(sctx));
       }
    }
 
@@ -74,7 +74,7 @@ namespace cycfi::elements
          {
             context sctx {ctx, &track(), ctx.bounds};
             sctx.bounds = track_bounds(sctx);
-            track().draw(sctx);
+            ELEMENTS_INSTRUMENT_CALL(draw, track(), track().draw(sctx));
          }
          auto bounds = thumb_bounds(ctx);
          auto thumbs = thumb();
@@ -83,14 +83,14 @@ namespace cycfi::elements
          {
             context sctx {ctx, &thumbs.first.get(), ctx.bounds};
             sctx.bounds = bounds.first;
-            thumbs.first.get().draw(sctx);
+            ELEMENTS_INSTRUMENT_CALL_AT(draw, thumbs.first.get(), 1, thumbs.first.get().draw(sctx));
          };
 
          auto draw_second = [&]()
          {
             context sctx {ctx, &thumbs.second.get(), ctx.bounds};
             sctx.bounds = bounds.second;
-            thumbs.second.get().draw(sctx);
+            ELEMENTS_INSTRUMENT_CALL_AT(draw, thumbs.second.get(), 2, thumbs.second.get().draw(sctx));
          };
 
          switch (_state)
@@ -226,7 +226,7 @@ namespace cycfi::elements
 
    rect range_slider_base::track_bounds(context const& ctx) const
    {
-      auto  limits_ = track().limits(ctx);
+      auto  limits_ = ELEMENTS_INSTRUMENT_CALL(limits, track(), track().limits(ctx));
       auto  bounds = ctx.bounds;
       auto  th_bounds = thumb_bounds(ctx);
 
@@ -251,12 +251,12 @@ namespace cycfi::elements
 
    std::pair<rect, rect> range_slider_base::thumb_bounds(context const& ctx) const
    {
-      auto get_single_bound = [this] (context const& ctx, auto const& thumb, double value)
+      auto get_single_bound = [this] (context const& ctx, auto const& thumb, [[maybe_unused]] std::size_t index, double value)
       {
          auto  bounds = ctx.bounds;
          auto  w = bounds.width();
          auto  h = bounds.height();
-         auto  limits_ = thumb.limits(ctx);
+         auto  limits_ = ELEMENTS_INSTRUMENT_CALL_AT(limits, thumb, index, thumb.limits(ctx));
          auto  tmb_w = limits_.max.x;
          auto  tmb_h = limits_.max.y;
 
@@ -273,18 +273,18 @@ namespace cycfi::elements
          }
       };
       return std::make_pair(
-         get_single_bound(ctx, thumb().first.get(), value_first()),
-         get_single_bound(ctx, thumb().second.get(), value_second())
+         get_single_bound(ctx, thumb().first.get(), 1, value_first()),
+         get_single_bound(ctx, thumb().second.get(), 2, value_second())
       );
    }
 
-   inline auto value_from_point = [](context const& ctx, point p, auto const& thumb, bool _is_horiz)
+   inline auto value_from_point = [](context const& ctx, point p, auto const& thumb, [[maybe_unused]] std::size_t index, bool _is_horiz)
    {
       auto  bounds = ctx.bounds;
       auto  w = bounds.width();
       auto  h = bounds.height();
 
-      auto  limits_ = thumb.limits(ctx);
+      auto  limits_ = ELEMENTS_INSTRUMENT_CALL_AT(limits, thumb, index, thumb.limits(ctx));
       auto  tmb_w = limits_.max.x;
       auto  tmb_h = limits_.max.y;
       auto  new_value = 0.0;
@@ -362,7 +362,7 @@ namespace cycfi::elements
 
    void range_slider_base::move_first(context const& ctx, tracker_info& track_info)
    {
-      auto new_value = value_from_point(ctx, track_info.current, thumb().first.get(), _is_horiz);
+      auto new_value = value_from_point(ctx, track_info.current, thumb().first.get(), 1, _is_horiz);
       new_value = handle_possible_collision_first(ctx, new_value);
       if (_value.first != new_value)
       {
@@ -373,7 +373,7 @@ namespace cycfi::elements
 
    void range_slider_base::move_second(context const& ctx, tracker_info& track_info)
    {
-      auto new_value = value_from_point(ctx, track_info.current, thumb().second.get(), _is_horiz);
+      auto new_value = value_from_point(ctx, track_info.current, thumb().second.get(), 2, _is_horiz);
       new_value = handle_possible_collision_second(ctx, new_value);
       if (_value.second != new_value)
       {
@@ -384,7 +384,7 @@ namespace cycfi::elements
 
    void range_slider_base::move_both_from_first(context const& ctx, tracker_info& track_info)
    {
-      auto new_value = value_from_point(ctx, track_info.current, thumb().first.get(), _is_horiz);
+      auto new_value = value_from_point(ctx, track_info.current, thumb().first.get(), 1, _is_horiz);
       auto deltax = new_value - _value.first;
       if (1 < _value.second + deltax)
       {
@@ -396,7 +396,7 @@ namespace cycfi::elements
 
    void range_slider_base::move_both_from_second(context const& ctx, tracker_info& track_info)
    {
-      auto new_value = value_from_point(ctx, track_info.current, thumb().second.get(), _is_horiz);
+      auto new_value = value_from_point(ctx, track_info.current, thumb().second.get(), 2, _is_horiz);
       auto deltax = new_value - _value.second;
       if (_value.first + deltax < 0)
       {
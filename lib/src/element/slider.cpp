@@ -12,8 +12,8 @@ namespace cycfi::elements
 {
    view_limits slider_base::limits(basic_context const& ctx) const
    {
-      auto  limits_ = track().limits(ctx);
-      auto  tmb_limits = thumb().limits(ctx);
+      auto  limits_ = ELEMENTS_INSTRUMENT_CALL(limits, track(), track().limits(ctx));
+      auto  tmb_limits = ELEMENTS_INSTRUMENT_CALL_AT(limits, thumb(), 1, thumb().limits(ctx));
 
       // We multiply thumb min limits by 2 so that there is always some space to move it.
       if (_is_horiz = limits_.max.x > limits_.max.y; _is_horiz)
@@ -37,12 +37,12 @@ namespace cycfi::elements
       {
          context sctx {ctx, &track(), ctx.bounds};
          sctx.bounds = track_bounds(sctx);
-         track().layout(sctx);
+         ELEMENTS_INSTRUMENT_CALL(layout, track(), track().layout(sctx));
       }
       {
          context sctx {ctx, &thumb(), ctx.bounds};
          sctx.bounds = thumb_bounds(sctx);
-         thumb().layout(sctx);
+         ELEMENTS_INSTRUMENT_CALL_AT(layout, thumb(), 1, thumb().layout(sctx));
       }
    }
 
@@ -53,12 +53,12 @@ namespace cycfi::elements
          {
             context sctx {ctx, &track(), ctx.bounds};
             sctx.bounds = track_bounds(sctx);
-            track().draw(sctx);
+            ELEMENTS_INSTRUMENT_CALL(draw, track(), track().draw(sctx));
          }
          {
             context sctx {ctx, &thumb(), ctx.bounds};
             sctx.bounds = thumb_bounds(sctx);
-            thumb().draw(sctx);
+            ELEMENTS_INSTRUMENT_CALL_AT(draw, thumb(), 1, thumb().draw(sctx));
          }
       }
    }
@@ -76,7 +76,7 @@ namespace cycfi::elements
 
    rect slider_base::track_bounds(context const& ctx) const
    {
-      auto  limits_ = track().limits(ctx);
+      auto  limits_ = ELEMENTS_INSTRUMENT_CALL(limits, track(), track().limits(ctx));
       auto  bounds = ctx.bounds;
       auto  th_bounds = thumb_bounds(ctx);
 
@@ -104,7 +104,7 @@ namespace cycfi::elements
       auto  bounds = ctx.bounds;
       auto  w = bounds.width();
       auto  h = bounds.height();
-      auto  limits_ = thumb().limits(ctx);
+      auto  limits_ = ELEMENTS_INSTRUMENT_CALL_AT(limits, thumb(), 1, thumb().limits(ctx));
       auto  tmb_w = limits_.max.x;
       auto  tmb_h = limits_.max.y;
 
@@ -127,7 +127,7 @@ namespace cycfi::elements
       auto  w = bounds.width();
       auto  h = bounds.height();
 
-      auto  limits_ = thumb().limits(ctx);
+      auto  limits_ = ELEMENTS_INSTRUMENT_CALL_AT(limits, thumb(), 1, thumb().limits(ctx));
       auto  tmb_w = limits_.max.x;
       auto  tmb_h = limits_.max.y;
       auto  new_value = 0.0;
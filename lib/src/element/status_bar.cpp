@@ -15,8 +15,8 @@ namespace cycfi::elements
 {
    view_limits status_bar_base::limits(basic_context const& ctx) const
    {
-      auto const fg_limits = foreground().limits(ctx);
-      auto bg_limits = background().limits(ctx);
+      auto const fg_limits = ELEMENTS_INSTRUMENT_CALL_AT(limits, foreground(), 1, foreground().limits(ctx));
+      auto bg_limits = ELEMENTS_INSTRUMENT_CALL(limits, background(), background().limits(ctx));
 
       bg_limits.min.y = std::max(bg_limits.min.y, fg_limits.min.y);
       bg_limits.min.x = std::max(bg_limits.min.x, fg_limits.min.x);
@@ -34,12 +34,12 @@ namespace cycfi::elements
       {
          context sctx {ctx, &background(), ctx.bounds};
          sctx.bounds = background_bounds(sctx);
-         background().layout(sctx);
+         ELEMENTS_INSTRUMENT_CALL(layout, background(), background().layout(sctx));
       }
       {
          context sctx {ctx, &foreground(), ctx.bounds};
          sctx.bounds = foreground_bounds(sctx);
-         foreground().layout(sctx);
+         ELEMENTS_INSTRUMENT_CALL_AT(layout, foreground(), 1, foreground().layout(sctx));
       }
    }
 
@@ -50,12 +50,12 @@ namespace cycfi::elements
          {
             context sctx {ctx, &background(), ctx.bounds};
             sctx.bounds = background_bounds(sctx);
-            background().draw(sctx);
+            ELEMENTS_INSTRUMENT_CALL(draw, background(), background().draw(sctx));
          }
          {
             context sctx {ctx, &foreground(), ctx.bounds};
             sctx.bounds = foreground_bounds(sctx);
-            foreground().draw(sctx);
+            ELEMENTS_INSTRUMENT_CALL_AT(draw, foreground(), 1, foreground().draw(sctx));
          }
       }
    }
@@ -67,7 +67,7 @@ namespace cycfi::elements
 
    rect status_bar_base::background_bounds(context const& ctx) const
    {
-      auto const limits_ = background().limits(ctx);
+      auto const limits_ = ELEMENTS_INSTRUMENT_CALL(limits, background(), background().limits(ctx));
       auto bounds = ctx.bounds;
       bounds.height(std::min<float>(limits_.max.y, bounds.height()));
       bounds.width(std::min<float>(limits_.max.x, bounds.width()));
@@ -151,7 +151,7 @@ namespace cycfi::elements
          _status = -1 * _animation_width;
          value(0.0);
          start_pos(0.0);
-         view_.refresh();
+         view_.refresh(*this);
          return;
       }
 
@@ -160,7 +160,7 @@ namespace cycfi::elements
       value(_status + _animation_width);
       if (_status >= 1.0)
          _status = -1 * _animation_width;
-      view_.refresh();
+      view_.refresh(*this);
       view_.post(std::chrono::duration_cast<std::chrono::milliseconds>(_time),
          [&view_, this]()
          {
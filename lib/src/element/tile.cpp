@@ -6,6 +6,7 @@
 =============================================================================*/
 #include <elements/element/tile.hpp>
 #include <elements/support/context.hpp>
+#include <elements/support/instrument.hpp>
 
 #include <algorithm>
 #include <numeric>
@@ -99,7 +100,7 @@ namespace cycfi::elements
                              Axis == axis::x ? full_extent : 0.0}};
          for (std::size_t i = 0; i != tile.size();  ++i)
          {
-            auto el = tile.at(i).limits(ctx);
+            auto el = ELEMENTS_INSTRUMENT_CALL_AT(limits, tile.at(i), i, tile.at(i).limits(ctx));
 
             limits.min[Axis] += el.min[Axis];
             limits.max[Axis] += el.max[Axis];
@@ -123,7 +124,7 @@ namespace cycfi::elements
          for (std::size_t i = 0; i != sz; ++i)
          {
             auto& elem = tile.at(i);
-            auto limits = elem.limits(ctx);
+            auto limits = ELEMENTS_INSTRUMENT_CALL_AT(limits, elem, i, elem.limits(ctx));
             info[i].stretch = elem.stretch()[Axis];
             info[i].min = limits.min[Axis];
             info[i].max = limits.max[Axis];
@@ -151,7 +152,7 @@ namespace cycfi::elements
             auto& elem = tile.at(i);
             auto ebounds = make_rect(Axis, prev+my_axis_min, other_axis_min, curr+my_axis_min, other_axis_max);
 
-            elem.layout(context{ctx, &elem, ebounds});
+            ELEMENTS_INSTRUMENT_CALL_AT(layout, elem, i, elem.layout(context{ctx, &elem, ebounds}));
           }
       }
 
@@ -4,76 +4,221 @@
    Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
 =============================================================================*/
 #include <elements/support/canvas.hpp>
+#include <elements/support/theme.hpp>
+#include <elements/support/tiled_pixmap.hpp>
 #include <cairo.h>
 
-#include <memory>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
 
 namespace cycfi { namespace elements
 {
    namespace
    {
-      struct cairo_pattern_deleter
+      using color_stops = std::vector<canvas::color_stop>;
+      using gradient_key = std::vector<float>;
+
+      void add_color_stops(cairo_pattern_t* pat, color_stops const& space)
       {
-         void operator()(cairo_pattern_t* pattern) const
+         for (auto cs : space)
          {
-            if (pattern)
-               cairo_pattern_destroy(pattern);
+            cairo_pattern_add_color_stop_rgba(
+               pat, cs.offset,
+               cs.color.red, cs.color.green, cs.color.blue, cs.color.alpha
+            );
          }
-      };
+      }
 
-      // use shared pointer instead of unique because std::function wants copyable types
-      using cairo_pattern_ptr = std::shared_ptr<cairo_pattern_t>;
+      void add_color_stops(gradient_key& key, color_stops const& space)
+      {
+         for (auto cs : space)
+         {
+            key.insert(key.end(),
+               {cs.offset, cs.color.red, cs.color.green, cs.color.blue, cs.color.alpha}
+            );
+         }
+      }
 
-      cairo_pattern_ptr make_linear_pattern(canvas::linear_gradient const& gr)
+      ////////////////////////////////////////////////////////////////////////
+      // Gradient patterns are cached process-wide, keyed by the gradient
+      // geometry (normalized to unit space where possible) and its color
+      // stops. The transform from unit space back to user space is applied
+      // when the pattern is set as the cairo source (see canvas::set_source).
+      // Canvases hold their own reference to the patterns they use, so the
+      // cache can be flushed anytime.
+      ////////////////////////////////////////////////////////////////////////
+      class pattern_cache
       {
-         cairo_pattern_t* pat = cairo_pattern_create_linear(
-            gr.start.x, gr.start.y, gr.end.x, gr.end.y
-         );
+      public:
+
+         static constexpr std::size_t max_size = 1024;
+
+                           ~pattern_cache() { clear(); }
+
+                           template <typename F>
+         cairo_pattern_t*  get(gradient_key const& key, F make);
+
+      private:
+
+         void              clear();
+
+         using map_type = std::map<gradient_key, cairo_pattern_t*>;
+
+         std::mutex        _mutex;
+         map_type          _map;
+         std::uint64_t     _theme_generation = 0;
+      };
+
+      template <typename F>
+      cairo_pattern_t* pattern_cache::get(gradient_key const& key, F make)
+      {
+         std::lock_guard<std::mutex> lock(_mutex);
 
-         for (auto cs : gr.space)
+         // Most gradients are derived from the theme. Flush the gradients
+         // of the previous theme when the theme changes.
+         if (auto gen = theme_generation(); gen != _theme_generation)
          {
-            cairo_pattern_add_color_stop_rgba(
-               pat, cs.offset,
-               cs.color.red, cs.color.green, cs.color.blue, cs.color.alpha
-            );
+            clear();
+            _theme_generation = gen;
          }
 
-         return cairo_pattern_ptr(pat, cairo_pattern_deleter{});
+         auto i = _map.find(key);
+         if (i == _map.end())
+         {
+            // Gradients that change continuously (e.g. animated) would
+            // otherwise grow the cache without bounds.
+            if (_map.size() >= max_size)
+               clear();
+            i = _map.emplace(key, make()).first;
+         }
+         return cairo_pattern_reference(i->second);
       }
 
-      cairo_pattern_ptr make_radial_pattern(canvas::radial_gradient const& gr)
+      void pattern_cache::clear()
       {
-         cairo_pattern_t* pat = cairo_pattern_create_radial(
-            gr.c1.x, gr.c1.y, gr.c1_radius,
-            gr.c2.x, gr.c2.y, gr.c2_radius
-         );
+         for (auto& entry : _map)
+            cairo_pattern_destroy(entry.second);
+         _map.clear();
+      }
+
+      pattern_cache& get_pattern_cache()
+      {
+         static pattern_cache cache;
+         return cache;
+      }
+
+      enum gradient_type { linear_gradient_type, radial_gradient_type };
 
-         for (auto cs : gr.space)
+      // Returns a (referenced) linear pattern from the cache. `transform` is
+      // set to the matrix that maps the pattern's space to user space.
+      cairo_pattern_t* linear_pattern(
+         canvas::linear_gradient const& gr, cairo_matrix_t& transform)
+      {
+         thread_local gradient_key key;
+         key.clear();
+         key.push_back(linear_gradient_type);
+
+         auto const dx = gr.end.x - gr.start.x;
+         auto const dy = gr.end.y - gr.start.y;
+         bool const normalize = dx != 0 || dy != 0;
+         if (normalize)
          {
-            cairo_pattern_add_color_stop_rgba(
-               pat, cs.offset,
-               cs.color.red, cs.color.green, cs.color.blue, cs.color.alpha
-            );
+            // Unit gradient from (0, 0) to (1, 0), rotated and scaled to the
+            // actual start and end points.
+            cairo_matrix_init(&transform, dx, dy, -dy, dx, gr.start.x, gr.start.y);
          }
+         else
+         {
+            cairo_matrix_init_identity(&transform);
+            key.insert(key.end(), {gr.start.x, gr.start.y});
+         }
+         add_color_stops(key, gr.space);
+
+         return get_pattern_cache().get(key,
+            [&]()
+            {
+               auto pat = normalize?
+                  cairo_pattern_create_linear(0, 0, 1, 0) :
+                  cairo_pattern_create_linear(gr.start.x, gr.start.y, gr.end.x, gr.end.y);
+               add_color_stops(pat, gr.space);
+               return pat;
+            }
+         );
+      }
 
-         return cairo_pattern_ptr(pat, cairo_pattern_deleter{});
+      // Returns a (referenced) radial pattern from the cache. `transform` is
+      // set to the matrix that maps the pattern's space to user space.
+      cairo_pattern_t* radial_pattern(
+         canvas::radial_gradient const& gr, cairo_matrix_t& transform)
+      {
+         thread_local gradient_key key;
+         key.clear();
+         key.push_back(radial_gradient_type);
+
+         // Radial gradients are normalized to a translation and a uniform
+         // scale with the first circle at the origin and the largest radius
+         // equal to 1.
+         auto const s = std::max(gr.c1_radius, gr.c2_radius);
+         bool const normalize = s > 0;
+         auto const c2 = normalize?
+            point{(gr.c2.x - gr.c1.x) / s, (gr.c2.y - gr.c1.y) / s} : gr.c2;
+         auto const c1 = normalize? point{0, 0} : gr.c1;
+         auto const r1 = normalize? gr.c1_radius / s : gr.c1_radius;
+         auto const r2 = normalize? gr.c2_radius / s : gr.c2_radius;
+
+         if (normalize)
+            cairo_matrix_init(&transform, s, 0, 0, s, gr.c1.x, gr.c1.y);
+         else
+            cairo_matrix_init_identity(&transform);
+
+         key.insert(key.end(), {c1.x, c1.y, r1, c2.x, c2.y, r2});
+         add_color_stops(key, gr.space);
+
+         return get_pattern_cache().get(key,
+            [&]()
+            {
+               auto pat = cairo_pattern_create_radial(c1.x, c1.y, r1, c2.x, c2.y, r2);
+               add_color_stops(pat, gr.space);
+               return pat;
+            }
+         );
       }
    }
 
    canvas::canvas(cairo_t& context_)
     : _context(context_)
    {
-      cairo_get_matrix(&context_, &_inv_affine);
+      cairo_get_matrix(&context_, &_affine);
+      _inv_affine = _affine;
       cairo_matrix_invert(&_inv_affine);
    }
 
+   canvas::canvas(cairo_t& context_, display_list& list)
+    : canvas(context_)
+   {
+      _display_list = &list;
+   }
+
    canvas::canvas(canvas&& rhs)
     : _context{rhs._context}
+    , _affine{rhs._affine}
     , _inv_affine{rhs._inv_affine}
-   {}
+    , _display_list{rhs._display_list}
+    , _state{rhs._state}
+    , _state_stack{rhs._state_stack}
+    , _state_depth{rhs._state_depth}
+    , _overflow{std::move(rhs._overflow)}
+    , _patterns{std::move(rhs._patterns)}
+   {
+      rhs._patterns.clear();
+   }
 
    canvas::~canvas()
    {
+      for (auto pat : _patterns)
+         cairo_pattern_destroy(pat);
    }
 
    void canvas::translate(point p)
@@ -148,29 +293,55 @@ namespace cycfi { namespace elements
    void canvas::fill()
    {
       apply_fill_style();
-      cairo_fill(&_context);
+      if (_display_list)
+      {
+         _display_list->fill(_context, _affine, current_source());
+         cairo_new_path(&_context);
+      }
+      else
+      {
+         cairo_fill(&_context);
+      }
    }
 
    void canvas::fill_preserve()
    {
       apply_fill_style();
-      cairo_fill_preserve(&_context);
+      if (_display_list)
+         _display_list->fill(_context, _affine, current_source());
+      else
+         cairo_fill_preserve(&_context);
    }
 
    void canvas::stroke()
    {
       apply_stroke_style();
-      cairo_stroke(&_context);
+      if (_display_list)
+      {
+         _display_list->stroke(_context, _affine, current_source());
+         cairo_new_path(&_context);
+      }
+      else
+      {
+         cairo_stroke(&_context);
+      }
    }
 
    void canvas::stroke_preserve()
    {
       apply_stroke_style();
-      cairo_stroke_preserve(&_context);
+      if (_display_list)
+         _display_list->stroke(_context, _affine, current_source());
+      else
+         cairo_stroke_preserve(&_context);
    }
 
    void canvas::clip()
    {
+      // When recording, the clip is also applied to the context, so clip
+      // queries and culling work as usual.
+      if (_display_list)
+         _display_list->clip(_context, _affine);
       cairo_clip(&_context);
    }
 
@@ -252,22 +423,131 @@ namespace cycfi { namespace elements
       add_round_rect(r, radius);
    }
 
-   void canvas::fill_style(color c)
+   void canvas::set_source(paint const& p)
    {
-      _state.fill_style = [this, c]()
+      switch (p.kind)
       {
-         cairo_set_source_rgba(&_context, c.red, c.green, c.blue, c.alpha);
-      };
+         case paint::solid:
+         {
+            auto const& c = p.solid_color;
+            cairo_set_source_rgba(&_context, c.red, c.green, c.blue, c.alpha);
+            break;
+         }
+         case paint::pattern:
+         {
+            // Lock the pattern to the current user space transformed by the
+            // paint's transform, then restore the current user space.
+            cairo_matrix_t ctm;
+            cairo_get_matrix(&_context, &ctm);
+            cairo_transform(&_context, &p.transform);
+            cairo_set_source(&_context, p.pattern_);
+            cairo_set_matrix(&_context, &ctm);
+            _state.source_ctm = ctm;
+            break;
+         }
+         default:
+            break;
+      }
+   }
+
+   display_list::source canvas::current_source() const
+   {
+      // The paint the last apply_fill_style or apply_stroke_style set as
+      // the cairo source
+      auto const& p = (_state.pattern_set == canvas_state::stroke_set)?
+         _state.stroke_style : _state.fill_style;
+
+      display_list::source src;
+      switch (p.kind)
+      {
+         case paint::solid:
+            src.solid_color = p.solid_color;
+            break;
+         case paint::pattern:
+         {
+            cairo_matrix_t m;
+            cairo_matrix_multiply(&m, &p.transform, &_state.source_ctm);
+            cairo_matrix_multiply(&src.matrix, &m, &_inv_affine);
+            src.kind = display_list::source::pattern;
+            src.pattern_ = p.pattern_;
+            break;
+         }
+         default:
+            src.solid_color = colors::black;  // cairo's default source
+            break;
+      }
+      return src;
+   }
+
+   void canvas::set_fill_paint(paint p)
+   {
+      if (_state.fill_style.kind == paint::pattern)
+      {
+         if (_state.fill_style.pattern_ != p.pattern_)
+         {
+            release_pattern(_state.fill_style.pattern_);
+         }
+         else
+         {
+            // The same (cached) gradient again: we already own a reference.
+            // Drop the one just acquired by own_pattern.
+            assert(_patterns.back() == p.pattern_);
+            cairo_pattern_destroy(_patterns.back());
+            _patterns.pop_back();
+         }
+      }
+      _state.fill_style = p;
       if (_state.pattern_set == _state.fill_set)
          _state.pattern_set = _state.none_set;
    }
 
-   void canvas::stroke_style(color c)
+   cairo_pattern_t* canvas::own_pattern(cairo_pattern_t* pat)
+   {
+      _patterns.push_back(pat);
+      return pat;
+   }
+
+   std::size_t canvas::patterns_mark() const
+   {
+      // The patterns owned before the innermost save are referred to by
+      // the saved states and must outlive them.
+      if (_state_depth == 0)
+         return 0;
+      if (_state_depth <= inline_states)
+         return _state_stack[_state_depth-1].num_patterns;
+      return _overflow.back().num_patterns;
+   }
+
+   void canvas::release_pattern(cairo_pattern_t* pat)
    {
-      _state.stroke_style = [this, c]()
+      // Only patterns set since the innermost save can be released: no
+      // saved state refers to them. Cairo and the display list hold
+      // references of their own.
+      auto first = _patterns.begin() + patterns_mark();
+      auto i = std::find(first, _patterns.end(), pat);
+      if (i != _patterns.end())
       {
-         cairo_set_source_rgba(&_context, c.red, c.green, c.blue, c.alpha);
-      };
+         cairo_pattern_destroy(*i);
+         _patterns.erase(i);
+      }
+   }
+
+   void canvas::release_patterns(std::size_t mark)
+   {
+      for (auto i = mark; i < _patterns.size(); ++i)
+         cairo_pattern_destroy(_patterns[i]);
+      if (mark < _patterns.size())
+         _patterns.resize(mark);
+   }
+
+   void canvas::fill_style(color c)
+   {
+      set_fill_paint({paint::solid, c, nullptr});
+   }
+
+   void canvas::stroke_style(color c)
+   {
+      _state.stroke_style = {paint::solid, c, nullptr};
       if (_state.pattern_set == _state.stroke_set)
          _state.pattern_set = _state.none_set;
    }
@@ -279,22 +559,16 @@ namespace cycfi { namespace elements
 
    void canvas::fill_style(linear_gradient const& gr)
    {
-      _state.fill_style = [this, pat = make_linear_pattern(gr)]()
-      {
-         cairo_set_source(&_context, pat.get());
-      };
-      if (_state.pattern_set == _state.fill_set)
-         _state.pattern_set = _state.none_set;
+      paint p{paint::pattern, {}, nullptr};
+      p.pattern_ = own_pattern(linear_pattern(gr, p.transform));
+      set_fill_paint(p);
    }
 
    void canvas::fill_style(radial_gradient const& gr)
    {
-      _state.fill_style = [this, pat = make_radial_pattern(gr)]()
-      {
-         cairo_set_source(&_context, pat.get());
-      };
-      if (_state.pattern_set == _state.fill_set)
-         _state.pattern_set = _state.none_set;
+      paint p{paint::pattern, {}, nullptr};
+      p.pattern_ = own_pattern(radial_pattern(gr, p.transform));
+      set_fill_paint(p);
    }
 
    void canvas::fill_rule(fill_rule_enum rule)
@@ -365,12 +639,41 @@ namespace cycfi { namespace elements
       }
    }
 
+   void canvas::show_text(char const* utf8)
+   {
+      if (!_display_list)
+      {
+         cairo_show_text(&_context, utf8);
+         return;
+      }
+
+      double x, y;
+      cairo_get_current_point(&_context, &x, &y);
+      cairo_glyph_t* glyphs = nullptr;
+      int num_glyphs = 0;
+      auto status = cairo_scaled_font_text_to_glyphs(
+         cairo_get_scaled_font(&_context), x, y, utf8, -1
+       , &glyphs, &num_glyphs, nullptr, nullptr, nullptr
+      );
+      if (status == CAIRO_STATUS_SUCCESS)
+         record_glyphs(glyphs, num_glyphs);
+      cairo_glyph_free(glyphs);
+   }
+
+   bool canvas::record_glyphs(cairo_glyph_t const* glyphs, int num_glyphs)
+   {
+      if (!_display_list)
+         return false;
+      _display_list->glyphs(_context, _affine, current_source(), glyphs, num_glyphs);
+      return true;
+   }
+
    void canvas::fill_text(point p, char const* utf8)
    {
       apply_fill_style();
       p = get_text_start(_context, p, _state.align, utf8);
       cairo_move_to(&_context, p.x, p.y);
-      cairo_show_text(&_context, utf8);
+      show_text(utf8);
    }
 
    void canvas::stroke_text(point p, char const* utf8)
@@ -388,7 +691,7 @@ namespace cycfi { namespace elements
       std::string utf8(utf8_);
       p = get_text_start(_context, p, _state.align, utf8.c_str());
       cairo_move_to(&_context, p.x, p.y);
-      cairo_show_text(&_context, utf8.c_str());
+      show_text(utf8.c_str());
    }
 
    void canvas::stroke_text(std::string_view utf8_, point p)
@@ -431,6 +734,14 @@ namespace cycfi { namespace elements
    }
 
    void canvas::draw(pixmap const& pm, elements::rect src, elements::rect dest)
+   {
+      draw_pixmap(pm, src, dest, false);
+   }
+
+   // If pad is true, the pixmap's edge pixels are extended beyond its
+   // bounds instead of fading to transparent. This avoids seams between
+   // adjacent tiles.
+   void canvas::draw_pixmap(pixmap const& pm, elements::rect src, elements::rect dest, bool pad)
    {
       auto  state = new_state();
       auto  w = dest.width();
@@ -438,21 +749,118 @@ namespace cycfi { namespace elements
       translate(dest.top_left());
       auto scale_ = point{w/src.width(), h/src.height()};
       scale(scale_);
-      cairo_set_source_surface(&_context, pm._surface, -src.left, -src.top);
+
+      // Draw from the smallest mip level that is at least as large as the
+      // destination, in device pixels.
+      double scx, scy;
+      cairo_surface_get_device_scale(pm._surface, &scx, &scy);
+      double dx = 1, dy = 1;
+      cairo_user_to_device_distance(&_context, &dx, &dy);
+      auto const ratio = std::max(std::abs(dx / scx), std::abs(dy / scy));
+      cairo_set_source_surface(&_context, pm.level(ratio), -src.left, -src.top);
+      if (pad)
+         cairo_pattern_set_extend(cairo_get_source(&_context), CAIRO_EXTEND_PAD);
       add_rect({0, 0, w/scale_.x, h/scale_.y});
-      cairo_fill(&_context);
+      if (_display_list)
+      {
+         display_list::source img{display_list::source::pattern, {}, nullptr};
+         img.pattern_ = cairo_get_source(&_context);
+         cairo_get_matrix(&_context, &img.matrix);
+         cairo_matrix_multiply(&img.matrix, &img.matrix, &_inv_affine);
+         _display_list->fill(_context, _affine, img);
+         cairo_new_path(&_context);
+      }
+      else
+      {
+         cairo_fill(&_context);
+      }
+   }
+
+   void canvas::draw(tiled_pixmap const& tp, elements::rect src, elements::rect dest)
+   {
+      // Draw only the tiles intersecting the visible part of dest
+      auto vis = intersection(dest, clip_extent());
+      if (vis.is_empty() || src.is_empty() || dest.is_empty())
+         return;
+
+      auto const sx = src.width() / dest.width();
+      auto const sy = src.height() / dest.height();
+      auto const to_src = [&](elements::rect r)
+      {
+         return elements::rect{
+            src.left + (r.left - dest.left) * sx, src.top + (r.top - dest.top) * sy
+          , src.left + (r.right - dest.left) * sx, src.top + (r.bottom - dest.top) * sy
+         };
+      };
+      auto const to_dest = [&](elements::rect r)
+      {
+         return elements::rect{
+            dest.left + (r.left - src.left) / sx, dest.top + (r.top - src.top) / sy
+          , dest.left + (r.right - src.left) / sx, dest.top + (r.bottom - src.top) / sy
+         };
+      };
+
+      // Device pixels per source (image) pixel
+      double dx = 1, dy = 1;
+      cairo_user_to_device_distance(&_context, &dx, &dy);
+      auto const ratio = std::max(std::abs(dx) / sx, std::abs(dy) / sy) * tp.scale();
+
+      auto state = new_state();
+      add_rect(dest);
+      clip();
+      for (auto const& t : tp.tiles(to_src(vis), ratio))
+      {
+         auto size = t.pixmap->size();
+         if (t.area == t.bounds)
+         {
+            draw_pixmap(*t.pixmap, {0, 0, size.x, size.y}, to_dest(t.bounds), true);
+         }
+         else
+         {
+            // A coarser tile standing in for a missing one
+            auto tile_state = new_state();
+            add_rect(to_dest(t.area));
+            clip();
+            draw_pixmap(*t.pixmap, {0, 0, size.x, size.y}, to_dest(t.bounds), true);
+         }
+      }
+   }
+
+   void canvas::draw(tiled_pixmap const& tp, elements::rect dest)
+   {
+      auto size = tp.size();
+      draw(tp, {0, 0, size.x, size.y}, dest);
    }
 
    void canvas::save()
    {
+      if (_display_list)
+         _display_list->save();
       cairo_save(&_context);
-      _state_stack.push(_state);
+      _state.num_patterns = _patterns.size();
+      if (_state_depth < inline_states)
+         _state_stack[_state_depth] = _state;
+      else
+         _overflow.push_back(_state);
+      ++_state_depth;
    }
 
    void canvas::restore()
    {
-      _state = _state_stack.top();
-      _state_stack.pop();
+      assert(_state_depth > 0);
+      --_state_depth;
+      if (_state_depth < inline_states)
+      {
+         _state = _state_stack[_state_depth];
+      }
+      else
+      {
+         _state = _overflow.back();
+         _overflow.pop_back();
+      }
+      release_patterns(_state.num_patterns);
       cairo_restore(&_context);
+      if (_display_list)
+         _display_list->restore();
    }
 }}
@@ -0,0 +1,572 @@
+/*=============================================================================
+   Copyright (c) 2016-2024 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/support/display_list.hpp>
+#include <elements/support/executor.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace cycfi::elements
+{
+   namespace
+   {
+      bool operator==(cairo_matrix_t const& a, cairo_matrix_t const& b)
+      {
+         return a.xx == b.xx && a.yx == b.yx && a.xy == b.xy
+            && a.yy == b.yy && a.x0 == b.x0 && a.y0 == b.y0;
+      }
+
+      cairo_matrix_t inverse(cairo_matrix_t m)
+      {
+         cairo_matrix_invert(&m);
+         return m;
+      }
+
+      // The transform from the current user space to the base space
+      cairo_matrix_t user_to_base(cairo_t& cr, cairo_matrix_t const& base)
+      {
+         cairo_matrix_t ctm, inv_base, r;
+         cairo_get_matrix(&cr, &ctm);
+         inv_base = inverse(base);
+         cairo_matrix_multiply(&r, &ctm, &inv_base);
+         return r;
+      }
+
+      rect transform_bounds(cairo_matrix_t const& m, double x1, double y1, double x2, double y2)
+      {
+         double xs[] = {x1, x2, x1, x2};
+         double ys[] = {y1, y1, y2, y2};
+         for (int i = 0; i != 4; ++i)
+            cairo_matrix_transform_point(&m, &xs[i], &ys[i]);
+         return {
+            float(*std::min_element(xs, xs+4)), float(*std::min_element(ys, ys+4))
+          , float(*std::max_element(xs, xs+4)), float(*std::max_element(ys, ys+4))
+         };
+      }
+
+      // The clip extents in base space
+      rect base_clip_extent(cairo_t& cr, cairo_matrix_t const& base)
+      {
+         cairo_matrix_t ctm;
+         cairo_get_matrix(&cr, &ctm);
+         cairo_set_matrix(&cr, &base);
+         double x1, y1, x2, y2;
+         cairo_clip_extents(&cr, &x1, &y1, &x2, &y2);
+         cairo_set_matrix(&cr, &ctm);
+         return {float(x1), float(y1), float(x2), float(y2)};
+      }
+
+      void set_relative_matrix(cairo_t& cr, cairo_matrix_t const& base, cairo_matrix_t const& m)
+      {
+         cairo_matrix_t r;
+         cairo_matrix_multiply(&r, &m, &base);
+         cairo_set_matrix(&cr, &r);
+      }
+   }
+
+   display_list::display_list(display_list&& rhs) noexcept
+   {
+      *this = std::move(rhs);
+   }
+
+   display_list::~display_list()
+   {
+      clear();
+   }
+
+   display_list& display_list::operator=(display_list&& rhs) noexcept
+   {
+      if (this != &rhs)
+      {
+         clear();
+         _commands.swap(rhs._commands);
+         _sources.swap(rhs._sources);
+         _path_data.swap(rhs._path_data);
+         _glyphs.swap(rhs._glyphs);
+         _patterns.swap(rhs._patterns);
+         _fonts.swap(rhs._fonts);
+      }
+      return *this;
+   }
+
+   void display_list::clear()
+   {
+      for (auto pat : _patterns)
+         cairo_pattern_destroy(pat);
+      for (auto font : _fonts)
+         cairo_scaled_font_destroy(font);
+
+      // Keep the capacities. A display list that records a frame after
+      // another does not allocate once it has grown to its working size.
+      _commands.clear();
+      _sources.clear();
+      _path_data.clear();
+      _glyphs.clear();
+      _patterns.clear();
+      _fonts.clear();
+   }
+
+   std::uint32_t display_list::add_source(source const& src)
+   {
+      if (!_sources.empty())
+      {
+         auto const& last = _sources.back();
+         if (last.kind == src.kind)
+         {
+            if (src.kind == source::solid && last.solid_color == src.solid_color)
+               return std::uint32_t(_sources.size()-1);
+            if (src.kind == source::pattern && last.pattern_ == src.pattern_ && last.matrix == src.matrix)
+               return std::uint32_t(_sources.size()-1);
+         }
+      }
+      if (src.kind == source::pattern)
+         _patterns.push_back(cairo_pattern_reference(src.pattern_));
+      _sources.push_back(src);
+      return std::uint32_t(_sources.size()-1);
+   }
+
+   bool display_list::add_path(cairo_t& cr, command& cmd)
+   {
+      auto path = cairo_copy_path(&cr);
+      bool const ok = path->status == CAIRO_STATUS_SUCCESS && path->num_data > 0;
+      if (ok)
+      {
+         cmd.first = std::uint32_t(_path_data.size());
+         cmd.count = std::uint32_t(path->num_data);
+         _path_data.insert(_path_data.end(), path->data, path->data + path->num_data);
+      }
+      cairo_path_destroy(path);
+      return ok;
+   }
+
+   bool display_list::same_source(std::uint32_t a, std::uint32_t b) const
+   {
+      if (a == b)
+         return true;
+      auto const& sa = _sources[a];
+      auto const& sb = _sources[b];
+      return sa.kind == source::solid && sb.kind == source::solid
+         && sa.solid_color == sb.solid_color;
+   }
+
+   void display_list::save()
+   {
+      _commands.push_back({save_op});
+   }
+
+   void display_list::restore()
+   {
+      // Elide empty save/restore pairs right away
+      if (!_commands.empty() && _commands.back().op == save_op)
+         _commands.pop_back();
+      else
+         _commands.push_back({restore_op});
+   }
+
+   void display_list::fill(cairo_t& cr, cairo_matrix_t const& base, source const& src)
+   {
+      cairo_matrix_t ctm;
+      cairo_get_matrix(&cr, &ctm);
+      cairo_set_matrix(&cr, &base);
+
+      double x1, y1, x2, y2;
+      cairo_fill_extents(&cr, &x1, &y1, &x2, &y2);
+      rect extent = {float(x1), float(y1), float(x2), float(y2)};
+
+      // Drop fills that are fully clipped out
+      command cmd{fill_op};
+      if (intersects(extent, base_clip_extent(cr, base)) && add_path(cr, cmd))
+      {
+         cmd.fill_rule = cairo_get_fill_rule(&cr);
+         cmd.source = add_source(src);
+         cmd.extent = extent;
+         _commands.push_back(cmd);
+      }
+      cairo_set_matrix(&cr, &ctm);
+   }
+
+   void display_list::stroke(cairo_t& cr, cairo_matrix_t const& base, source const& src)
+   {
+      double x1, y1, x2, y2;
+      cairo_stroke_extents(&cr, &x1, &y1, &x2, &y2);
+      auto const m = user_to_base(cr, base);
+      auto const extent = transform_bounds(m, x1, y1, x2, y2);
+
+      // Drop strokes that are fully clipped out
+      command cmd{stroke_op};
+      if (intersects(extent, base_clip_extent(cr, base)) && add_path(cr, cmd))
+      {
+         cmd.source = add_source(src);
+         cmd.line_width = cairo_get_line_width(&cr);
+         cmd.matrix = m;
+         cmd.extent = extent;
+         _commands.push_back(cmd);
+      }
+   }
+
+   void display_list::clip(cairo_t& cr, cairo_matrix_t const& base)
+   {
+      cairo_matrix_t ctm;
+      cairo_get_matrix(&cr, &ctm);
+      cairo_set_matrix(&cr, &base);
+
+      // An empty clip path clips everything. Record it as an empty path.
+      command cmd{clip_op};
+      add_path(cr, cmd);
+      cmd.fill_rule = cairo_get_fill_rule(&cr);
+      _commands.push_back(cmd);
+
+      cairo_set_matrix(&cr, &ctm);
+   }
+
+   void display_list::glyphs(
+      cairo_t& cr, cairo_matrix_t const& base, source const& src
+    , cairo_glyph_t const* glyphs, int num_glyphs
+   )
+   {
+      if (num_glyphs <= 0)
+         return;
+
+      cairo_text_extents_t ext;
+      cairo_glyph_extents(&cr, glyphs, num_glyphs, &ext);
+      auto const m = user_to_base(cr, base);
+      auto const extent = transform_bounds(
+         m, ext.x_bearing, ext.y_bearing
+       , ext.x_bearing + ext.width, ext.y_bearing + ext.height
+      );
+
+      // Drop glyph runs that are fully clipped out
+      if (!intersects(extent, base_clip_extent(cr, base)))
+         return;
+
+      command cmd{glyphs_op};
+      cmd.source = add_source(src);
+      cmd.first = std::uint32_t(_glyphs.size());
+      cmd.count = std::uint32_t(num_glyphs);
+      cmd.matrix = m;
+      cmd.font = cairo_scaled_font_reference(cairo_get_scaled_font(&cr));
+      cmd.extent = extent;
+      _fonts.push_back(cmd.font);
+      _glyphs.insert(_glyphs.end(), glyphs, glyphs + num_glyphs);
+      _commands.push_back(cmd);
+   }
+
+   void display_list::optimize()
+   {
+      // Elide save/restore pairs that do not scope a clip. Commands set
+      // their own matrix, source, fill rule and line width, so the clip is
+      // the only state a save/restore pair needs to preserve.
+      {
+         std::vector<std::pair<std::size_t, bool>> saves; // (index, has clip)
+         std::vector<bool> remove(_commands.size(), false);
+         for (std::size_t i = 0; i != _commands.size(); ++i)
+         {
+            switch (_commands[i].op)
+            {
+               case save_op:
+                  saves.emplace_back(i, false);
+                  break;
+               case clip_op:
+                  if (!saves.empty())
+                     saves.back().second = true;
+                  break;
+               case restore_op:
+                  if (!saves.empty())
+                  {
+                     if (!saves.back().second)
+                        remove[saves.back().first] = remove[i] = true;
+                     saves.pop_back();
+                  }
+                  break;
+               default:
+                  break;
+            }
+         }
+
+         std::size_t j = 0;
+         for (std::size_t i = 0; i != _commands.size(); ++i)
+         {
+            if (!remove[i])
+               _commands[j++] = _commands[i];
+         }
+         _commands.resize(j);
+      }
+
+      // Merge adjacent fills with the same source and fill rule. Only fills
+      // that do not overlap are merged: overlapping paths may cancel each
+      // other (fill rules) or blend differently (translucent paints).
+      if (!_commands.empty())
+      {
+         std::size_t j = 0;
+         for (std::size_t i = 1; i != _commands.size(); ++i)
+         {
+            auto& a = _commands[j];
+            auto const& b = _commands[i];
+            bool const merge =
+               a.op == fill_op && b.op == fill_op
+               && a.fill_rule == b.fill_rule
+               && same_source(a.source, b.source)
+               && a.first + a.count == b.first
+               && !intersects(a.extent, b.extent)
+               ;
+
+            if (merge)
+            {
+               a.count += b.count;
+               a.extent = max(a.extent, b.extent);
+            }
+            else
+            {
+               _commands[++j] = b;
+            }
+         }
+         _commands.resize(j+1);
+      }
+   }
+
+   void display_list::set_source(cairo_t& cr, cairo_matrix_t const& base, std::uint32_t index) const
+   {
+      auto const& src = _sources[index];
+      if (src.kind == source::solid)
+      {
+         auto const& c = src.solid_color;
+         cairo_set_source_rgba(&cr, c.red, c.green, c.blue, c.alpha);
+      }
+      else
+      {
+         // Lock the pattern to its recorded space
+         set_relative_matrix(cr, base, src.matrix);
+         cairo_set_source(&cr, src.pattern_);
+         cairo_set_matrix(&cr, &base);
+      }
+   }
+
+   void display_list::replay(cairo_t& cr) const
+   {
+      replay(cr, nullptr);
+   }
+
+   void display_list::replay(cairo_t& cr, rect const& region) const
+   {
+      replay(cr, &region);
+   }
+
+   void display_list::replay(cairo_t& cr, rect const* region) const
+   {
+      // Fills, strokes and glyphs outside the region are skipped. Save,
+      // restore and clip commands are always replayed, as they affect
+      // the commands that follow.
+      auto outside = [region](command const& cmd)
+      {
+         return region && !intersects(cmd.extent, *region);
+      };
+
+      cairo_matrix_t base;
+      cairo_get_matrix(&cr, &base);
+      cairo_save(&cr);
+
+      auto append_path = [&](command const& cmd)
+      {
+         cairo_new_path(&cr);
+         if (cmd.count)
+         {
+            cairo_path_t path{
+               CAIRO_STATUS_SUCCESS
+             , const_cast<cairo_path_data_t*>(_path_data.data() + cmd.first)
+             , int(cmd.count)
+            };
+            cairo_append_path(&cr, &path);
+         }
+      };
+
+      for (auto const& cmd : _commands)
+      {
+         switch (cmd.op)
+         {
+            case save_op:
+               cairo_save(&cr);
+               break;
+
+            case restore_op:
+               cairo_restore(&cr);
+               break;
+
+            case fill_op:
+               if (outside(cmd))
+                  break;
+               set_source(cr, base, cmd.source);
+               append_path(cmd);
+               cairo_set_fill_rule(&cr, cairo_fill_rule_t(cmd.fill_rule));
+               cairo_fill(&cr);
+               break;
+
+            case clip_op:
+               cairo_set_matrix(&cr, &base);
+               append_path(cmd);
+               cairo_set_fill_rule(&cr, cairo_fill_rule_t(cmd.fill_rule));
+               cairo_clip(&cr);
+               break;
+
+            case stroke_op:
+               if (outside(cmd))
+                  break;
+               set_source(cr, base, cmd.source);
+               set_relative_matrix(cr, base, cmd.matrix);
+               append_path(cmd);
+               cairo_set_line_width(&cr, cmd.line_width);
+               cairo_stroke(&cr);
+               cairo_set_matrix(&cr, &base);
+               break;
+
+            case glyphs_op:
+               if (outside(cmd))
+                  break;
+               set_source(cr, base, cmd.source);
+               set_relative_matrix(cr, base, cmd.matrix);
+               cairo_set_scaled_font(&cr, cmd.font);
+               cairo_show_glyphs(&cr, _glyphs.data() + cmd.first, int(cmd.count));
+               cairo_set_matrix(&cr, &base);
+               break;
+         }
+      }
+
+      cairo_restore(&cr);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   // Banded replay
+   ////////////////////////////////////////////////////////////////////////////
+   namespace
+   {
+      // Bands smaller than this (in device pixels) are not worth the
+      // overhead of dispatching them to another thread.
+      constexpr int min_band_height = 64;
+
+      // The user to device scale of cr, including the target's device
+      // scale. Returns 0 if the transform is not a uniform scale (plus
+      // translation), in which case we do not band.
+      double device_scale(cairo_t& cr)
+      {
+         double xx = 1, xy = 0, yx = 0, yy = 1;
+         cairo_user_to_device_distance(&cr, &xx, &xy);
+         cairo_user_to_device_distance(&cr, &yx, &yy);
+         if (xy != 0 || yx != 0 || std::abs(xx) != std::abs(yy) || xx == 0)
+            return 0;
+
+         double sx = 1, sy = 1;
+         cairo_surface_get_device_scale(cairo_get_target(&cr), &sx, &sy);
+         if (sx != sy)
+            return 0;
+         return std::abs(xx) * sx;
+      }
+
+      struct band_state
+      {
+         std::atomic<int>        next{0};
+         int                     done = 0;
+         std::mutex              mutex;
+         std::condition_variable cv;
+      };
+   }
+
+   void display_list::replay(cairo_t& cr, executor& exec) const
+   {
+      auto scale = device_scale(cr);
+      double x1, y1, x2, y2;
+      cairo_clip_extents(&cr, &x1, &y1, &x2, &y2);
+
+      // The clip extent, in (scaled) device pixels
+      int px = int(std::floor(x1 * scale));
+      int py = int(std::floor(y1 * scale));
+      int width = int(std::ceil(x2 * scale)) - px;
+      int height = int(std::ceil(y2 * scale)) - py;
+
+      int num_bands = std::min<int>(exec.num_threads() + 1, height / min_band_height);
+      if (scale == 0 || width <= 0 || num_bands < 2)
+      {
+         replay(cr);
+         return;
+      }
+
+      auto image = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
+      if (cairo_surface_status(image) != CAIRO_STATUS_SUCCESS)
+      {
+         cairo_surface_destroy(image);
+         replay(cr);
+         return;
+      }
+      cairo_surface_flush(image);
+      auto data = cairo_image_surface_get_data(image);
+      auto stride = cairo_image_surface_get_stride(image);
+      auto band_height = (height + num_bands - 1) / num_bands;
+
+      // Draw band i into its own slice of the image. The slices do not
+      // overlap, so the bands can be drawn concurrently.
+      auto draw_band = [=, this](int i)
+      {
+         auto top = i * band_height;
+         auto rows = std::min(band_height, height - top);
+         auto band = cairo_image_surface_create_for_data(
+            data + std::ptrdiff_t(top) * stride, CAIRO_FORMAT_ARGB32, width, rows, stride
+         );
+         cairo_surface_set_device_scale(band, scale, scale);
+         auto band_cr = cairo_create(band);
+         cairo_translate(band_cr, -px / scale, -(py + top) / scale);
+
+         // The band in base space, padded by a pixel to allow for
+         // antialiasing and glyph hinting
+         auto pad = 1 / scale;
+         rect region = {
+            float(px / scale - pad)
+          , float((py + top) / scale - pad)
+          , float((px + width) / scale + pad)
+          , float((py + top + rows) / scale + pad)
+         };
+         replay(*band_cr, region);
+         cairo_destroy(band_cr);
+         cairo_surface_finish(band);
+         cairo_surface_destroy(band);
+      };
+
+      // The workers and this thread take bands from a shared counter, so
+      // we never wait for a band that has not started. The state is shared
+      // because tasks may start after all the bands are done (and we have
+      // returned). Such tasks find no band to draw, and touch nothing else.
+      auto state = std::make_shared<band_state>();
+      auto work = [state, num_bands, draw_band]
+      {
+         for (int i; (i = state->next++) < num_bands;)
+         {
+            draw_band(i);
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (++state->done == num_bands)
+               state->cv.notify_one();
+         }
+      };
+
+      for (int i = 1; i != num_bands; ++i)
+         exec.post(work);
+      work();
+      {
+         std::unique_lock<std::mutex> lock(state->mutex);
+         state->cv.wait(lock, [&]{ return state->done == num_bands; });
+      }
+
+      // Composite the bands onto cr
+      cairo_surface_mark_dirty(image);
+      cairo_surface_set_device_scale(image, scale, scale);
+      cairo_save(&cr);
+      cairo_set_source_surface(&cr, image, px / scale, py / scale);
+      cairo_paint(&cr);
+      cairo_restore(&cr);
+      cairo_surface_destroy(image);
+   }
+}
@@ -0,0 +1,155 @@
+/*=============================================================================
+   Copyright (c) 2016-2024 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/support/executor.hpp>
+#include <elements/support/pixmap.hpp>
+
+#include <algorithm>
+#include <deque>
+
+namespace cycfi::elements
+{
+   namespace
+   {
+      // The executor and worker index of the current thread, if it is one
+      // of an executor's workers.
+      thread_local executor const* current_executor = nullptr;
+      thread_local std::size_t current_worker = 0;
+   }
+
+   struct executor::worker_queue
+   {
+      std::mutex              mutex;
+      std::deque<entry>       tasks;
+   };
+
+   executor::executor(std::size_t num_threads)
+   {
+      if (num_threads == 0)
+         num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+      for (std::size_t i = 0; i != num_threads; ++i)
+         _queues.push_back(std::make_unique<worker_queue>());
+      for (std::size_t i = 0; i != num_threads; ++i)
+         _threads.emplace_back([this, i]{ run(i); });
+   }
+
+   executor::~executor()
+   {
+      {
+         std::lock_guard<std::mutex> lock(_sleep_mutex);
+         _stop = true;
+      }
+      _cv.notify_all();
+      for (auto& t : _threads)
+         t.join();
+   }
+
+   void executor::post(task t)
+   {
+      // Tasks posted by a worker go to its own queue
+      auto index = (current_executor == this)?
+         current_worker : _next++ % _queues.size();
+
+      {
+         auto& q = *_queues[index];
+         std::lock_guard<std::mutex> lock(q.mutex);
+         q.tasks.push_back({std::move(t), clock::now()});
+         ++_queued;
+      }
+
+      // Lock the sleep mutex so a worker can't miss the wakeup between
+      // checking _queued and waiting.
+      {
+         std::lock_guard<std::mutex> lock(_sleep_mutex);
+      }
+      _cv.notify_one();
+   }
+
+   // Pop the oldest task from our own queue, else steal the newest task
+   // from another worker's queue.
+   bool executor::pop(std::size_t index, entry& e)
+   {
+      auto const n = _queues.size();
+      for (std::size_t i = 0; i != n; ++i)
+      {
+         auto& q = *_queues[(index + i) % n];
+         std::lock_guard<std::mutex> lock(q.mutex);
+         if (q.tasks.empty())
+            continue;
+         if (i == 0)
+         {
+            e = std::move(q.tasks.front());
+            q.tasks.pop_front();
+         }
+         else
+         {
+            e = std::move(q.tasks.back());
+            q.tasks.pop_back();
+            ++_stolen;
+         }
+         --_queued;
+         return true;
+      }
+      return false;
+   }
+
+   void executor::run(std::size_t index)
+   {
+      current_executor = this;
+      current_worker = index;
+
+      while (true)
+      {
+         entry e;
+         if (!pop(index, e))
+         {
+            std::unique_lock<std::mutex> lock(_sleep_mutex);
+            _cv.wait(lock, [this]{ return _stop || _queued > 0; });
+            if (_stop)
+               return;
+            continue;
+         }
+
+         // Queued tasks are dropped when we are stopped
+         if (_stop)
+            return;
+
+         ++_started;
+         auto latency = (clock::now() - e.posted).count();
+         _total_latency += latency;
+         auto max = _max_latency.load();
+         while (latency > max && !_max_latency.compare_exchange_weak(max, latency))
+            ;
+
+         e.t();
+         ++_executed;
+      }
+   }
+
+   executor_stats executor::stats() const
+   {
+      executor_stats s;
+      s.threads = _threads.size();
+      s.queued = _queued;
+      s.executed = _executed;
+      s.stolen = _stolen;
+      auto started = _started.load();
+      if (started)
+         s.mean_latency = executor_stats::duration{_total_latency / std::int64_t(started)};
+      s.max_latency = executor_stats::duration{_max_latency.load()};
+      return s;
+   }
+
+   executor& shared_executor()
+   {
+      // Make sure the pixmap cache, used by the workers, is constructed
+      // before (and thus destroyed after) the executor.
+      pixmap_cache_statistics();
+
+      static executor exec;
+      return exec;
+   }
+}
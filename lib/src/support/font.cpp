@@ -5,6 +5,8 @@
    Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
 =============================================================================*/
 #include <elements/support/font.hpp>
+#include <elements/support/theme.hpp>
+#include <elements/support/detail/mapped_file.hpp>
 #include <infra/assert.hpp>
 
 #include <cairo.h>
@@ -31,6 +33,7 @@
 # include <cairo-quartz.h>
 #endif
 
+#include <atomic>
 #include <map>
 #include <mutex>
 #include <memory>
@@ -298,7 +301,18 @@ namespace cycfi { namespace elements
          }
       } // namespace
 
-      using cairo_font_map_type = std::map<std::string, cairo_font_face_t*>;
+      // The font faces loaded so far, keyed by full name. Faces that no
+      // font object refers to are released, least recently used first, when
+      // the memory used by the (mapped) font files exceeds
+      // `font_memory_limit()`. `bytes` is the size of the face's font file.
+      struct cached_face
+      {
+         cairo_font_face_t*   face = nullptr;
+         std::uint64_t        last_use = 0;
+         std::size_t          bytes = 0;
+      };
+
+      using cairo_font_map_type = std::map<std::string, cached_face>;
 
       std::pair<cairo_font_map_type&, std::mutex&> get_cairo_font_map()
       {
@@ -310,8 +324,8 @@ namespace cycfi { namespace elements
             ~cleanup()
             {
                std::lock_guard<std::mutex> lock(cairo_font_map_mutex_);
-               for (auto [key, scaled_font] : cairo_font_map_)
-                  cairo_font_face_destroy(scaled_font);
+               for (auto& [key, entry] : cairo_font_map_)
+                  cairo_font_face_destroy(entry.face);
                cairo_font_map_.clear();
             }
          };
@@ -320,6 +334,103 @@ namespace cycfi { namespace elements
          return {cairo_font_map_, cairo_font_map_mutex_};
       }
 
+      std::atomic<std::size_t>& memory_limit()
+      {
+         static std::atomic<std::size_t> limit{64 * 1024 * 1024};
+         return limit;
+      }
+
+      // Total size of the font files currently mapped in memory
+      std::atomic<std::size_t>& mapped_bytes()
+      {
+         static std::atomic<std::size_t> bytes{0};
+         return bytes;
+      }
+
+      // Incremented whenever faces are released from the font map, so
+      // that pointers to the faces and entries kept elsewhere (see
+      // resolved_fonts) can be validated. Guarded by the font map mutex.
+      std::uint64_t& font_map_generation()
+      {
+         static std::uint64_t generation = 0;
+         return generation;
+      }
+
+      // For the least recently used order. Guarded by the font map mutex.
+      std::uint64_t next_use()
+      {
+         static std::uint64_t use_count = 0;
+         return ++use_count;
+      }
+
+      // The number of font objects referring to a face, attached to the
+      // faces in the font map. This is distinct from the face's reference
+      // count, which also counts the references cairo holds for itself
+      // (e.g. its scaled font caches).
+      auto const& font_users_key()
+      {
+         static const cairo_user_data_key_t key = {};
+         return key;
+      }
+
+      std::atomic<int>* font_users(cairo_font_face_t* face)
+      {
+         return static_cast<std::atomic<int>*>(
+            cairo_font_face_get_user_data(face, &font_users_key()));
+      }
+
+      // Release the faces no font object refers to, least recently used
+      // first, until we are within the memory limit. Cairo may still hold
+      // references to a released face, and to its file, for a while. So we
+      // count the bytes released instead of waiting for mapped_bytes() to
+      // drop. The font map must be locked by the caller.
+      void trim_font_map(cairo_font_map_type& map)
+      {
+         std::size_t const limit = memory_limit();
+         std::size_t bytes = mapped_bytes();
+         bool released = false;
+         while (bytes > limit)
+         {
+            auto lru = map.end();
+            for (auto i = map.begin(); i != map.end(); ++i)
+            {
+               auto users = font_users(i->second.face);
+               if (users && *users == 0
+                  && (lru == map.end() || i->second.last_use < lru->second.last_use))
+                  lru = i;
+            }
+            if (lru == map.end())
+               break;   // All faces are in use
+            bytes -= std::min(bytes, lru->second.bytes);
+            cairo_font_face_destroy(lru->second.face);
+            map.erase(lru);
+            released = true;
+         }
+         if (released)
+            ++font_map_generation();
+      }
+
+      // Called when a font object no longer refers to `face`
+      void release_font_face(cairo_font_face_t* face)
+      {
+         auto users = font_users(face);
+         bool const unused = users && --*users == 0;
+         cairo_font_face_destroy(face);
+         if (unused && mapped_bytes() > memory_limit())
+         {
+            auto [cairo_font_map, cairo_font_map_mutex] = get_cairo_font_map();
+            std::lock_guard<std::mutex> lock(cairo_font_map_mutex);
+            trim_font_map(cairo_font_map);
+         }
+      }
+
+      cairo_font_face_t* acquire_font_face(cairo_font_face_t* face)
+      {
+         if (auto users = font_users(face))
+            ++*users;
+         return cairo_font_face_reference(face);
+      }
+
       int map_fc_weight(int w)
       {
          enum
@@ -365,10 +476,11 @@ namespace cycfi { namespace elements
 
       struct font_entry
       {
-         font_entry(FcPattern* pat, FcChar8 const* full_name, FcChar8 const* file)
+         font_entry(FcPattern* pat, FcChar8 const* full_name, FcChar8 const* file, int index)
          : pattern(fc::pattern_shallow_copy_tag{}, *pat)
          , full_name(reinterpret_cast<char const*>(full_name))
          , file(reinterpret_cast<char const*>(file))
+         , index(index)
          {
             if (auto w = pattern.get_weight(); w)
                weight = map_fc_weight(*w); // map the weight (normalized 0 to 100)
@@ -389,6 +501,7 @@ namespace cycfi { namespace elements
          fc::pattern pattern;
          std::string full_name;
          std::string file;
+         int index;              // Face index, for font collections
          std::uint8_t weight;
          std::uint8_t slant;
          std::uint8_t stretch;
@@ -422,7 +535,7 @@ namespace cycfi { namespace elements
             conf.app_font_add_dir(reinterpret_cast<FcChar8 const*>(path.generic_string().c_str()));
 
          fc::pattern pat(fc::pattern_empty_tag{});
-         fc::object_set os(FC_FAMILY, FC_FULLNAME, FC_WIDTH, FC_WEIGHT, FC_SLANT, FC_FILE);
+         fc::object_set os(FC_FAMILY, FC_FULLNAME, FC_WIDTH, FC_WEIGHT, FC_SLANT, FC_FILE, FC_INDEX);
          fc::font_set_ptr fs = fc::font_list(conf.get(), pat, os);
 
          for (int i = 0; i < fs->nfont; ++i)
@@ -437,7 +550,9 @@ namespace cycfi { namespace elements
                std::string key = reinterpret_cast<char const*>(family);
                trim(key);
 
-               font_map()[key].push_back(font_entry(font, full_name, file));
+               int index = 0;
+               FcPatternGetInteger(font, FC_INDEX, 0, &index);
+               font_map()[key].push_back(font_entry(font, full_name, file, index));
             }
          }
       }
@@ -530,9 +645,88 @@ namespace cycfi { namespace elements
          FT_Face _face = nullptr;
       };
 
-      void destroy_free_type_face(void* face)
+      ////////////////////////////////////////////////////////////////////////
+      // A read-only memory mapping of a font file. Font files are mapped
+      // once and shared by all the faces loaded from them (e.g. the faces
+      // of a font collection).
+      ////////////////////////////////////////////////////////////////////////
+      class mapped_font_file
+      {
+      public:
+
+         using ptr = std::shared_ptr<mapped_font_file>;
+
+                              ~mapped_font_file();
+
+                              mapped_font_file(mapped_font_file const&) = delete;
+         mapped_font_file&    operator=(mapped_font_file const&) = delete;
+
+         static ptr           get(std::string const& path);
+
+         FT_Byte const*       data() const { return _file.data(); }
+         FT_Long              size() const { return FT_Long(_file.size()); }
+
+      private:
+
+                              mapped_font_file(std::string const& path)
+                               : _file(path)
+                              {}
+
+         detail::mapped_file  _file;
+      };
+
+      mapped_font_file::ptr mapped_font_file::get(std::string const& path)
+      {
+         static std::map<std::string, std::weak_ptr<mapped_font_file>> files;
+         static std::mutex files_mutex;
+
+         std::lock_guard<std::mutex> lock(files_mutex);
+         if (auto i = files.find(path); i != files.end())
+         {
+            if (auto file = i->second.lock())
+               return file;
+         }
+
+         ptr file{new mapped_font_file{path}};
+         if (!file->_file)
+            return {};
+         mapped_bytes() += file->_file.size();
+         files[path] = file;
+         return file;
+      }
+
+      mapped_font_file::~mapped_font_file()
       {
-         FT_Done_Face(reinterpret_cast<FT_Face>(face));
+         mapped_bytes() -= _file.size();
+      }
+
+      // Attached to the cairo font face. Keeps the FreeType face and the
+      // mapped file it is loaded from alive for as long as the cairo font
+      // face is alive.
+      struct free_type_face_data
+      {
+         FT_Face                 face;
+         mapped_font_file::ptr   file;
+      };
+
+      // FT_Library is not thread safe. Faces are created and destroyed
+      // (FT_New_Memory_Face and FT_Done_Face), both of which modify the
+      // library, under this mutex. Faces are destroyed in whatever thread
+      // releases the last reference to the cairo font face.
+      std::mutex& free_type_mutex()
+      {
+         static std::mutex mutex;
+         return mutex;
+      }
+
+      void destroy_free_type_face(void* data)
+      {
+         auto p = static_cast<free_type_face_data*>(data);
+         {
+            std::lock_guard<std::mutex> lock(free_type_mutex());
+            FT_Done_Face(p->face);
+         }
+         delete p;
       }
 
       class free_type_library
@@ -572,36 +766,28 @@ namespace cycfi { namespace elements
             std::swap(lhs._ft_lib, rhs._ft_lib);
          }
 
-         free_type_face load_face(char const* font_path)
-         {
-            FT_Face ft_face;
-            FT_Error ft_status = FT_New_Face(_ft_lib, font_path, 0, &ft_face);
-
-            if (ft_status == 0)
-               return free_type_face(ft_face);
-            else
-               return free_type_face(nullptr);
-         }
-
          [[nodiscard]]
-         cairo_font_face_t* load_font(char const* font_path)
+         cairo_font_face_t* load_font(std::string const& font_path, int index)
          {
-            free_type_face ft_face = load_face(font_path);
-            if (!ft_face)
+            auto file = mapped_font_file::get(font_path);
+            if (!file)
                return nullptr;
 
+            FT_Face face;
+            std::lock_guard<std::mutex> lock(free_type_mutex());
+            if (FT_New_Memory_Face(_ft_lib, file->data(), file->size(), index, &face) != 0)
+               return nullptr;
+
+            free_type_face ft_face{face};
             cairo_font_face_t* cairo_face = cairo_ft_font_face_create_for_ft_face(ft_face.handle(), 0);
             if (cairo_face == nullptr)
                return nullptr;
 
-            // extend the freetype font face lifetime to cairo's font face lifetime
-            cairo_status_t cairo_status = CAIRO_STATUS_SUCCESS;
-            cairo_user_data_key_t const& key = cairo_user_data_key();
-            if (cairo_font_face_get_user_data(cairo_face, &key) != ft_face.handle())
-            {
-               cairo_status = cairo_font_face_set_user_data(
-                  cairo_face, &key, ft_face.handle(), &destroy_free_type_face);
-            }
+            // extend the freetype font face and the mapped file lifetime to
+            // cairo's font face lifetime
+            auto data = new free_type_face_data{ft_face.handle(), std::move(file)};
+            cairo_status_t cairo_status = cairo_font_face_set_user_data(
+               cairo_face, &cairo_user_data_key(), data, &destroy_free_type_face);
 
             if (cairo_status == CAIRO_STATUS_SUCCESS)
             {
@@ -609,6 +795,7 @@ namespace cycfi { namespace elements
             }
             else
             {
+               delete data;
                cairo_font_face_destroy(cairo_face);
                return nullptr;
             }
@@ -628,54 +815,223 @@ namespace cycfi { namespace elements
       return _paths;
    }
 
-   font::font(font_descr descr)
+   void font_memory_limit(std::size_t bytes)
+   {
+      memory_limit() = bytes;
+      auto [cairo_font_map, cairo_font_map_mutex] = get_cairo_font_map();
+      std::lock_guard<std::mutex> lock(cairo_font_map_mutex);
+      trim_font_map(cairo_font_map);
+   }
+
+   std::size_t font_memory_limit()
+   {
+      return memory_limit();
+   }
+
+   namespace
    {
+      // A font face loaded for a font object, and its font map entry as of
+      // the font map generation, `generation`.
+      struct loaded_face
+      {
+         cairo_font_face_t*   face = nullptr;
+         cached_face*         cached = nullptr;
+         std::uint64_t        generation = 0;
+      };
+
+      // Loads the font face that best matches `descr`. The face is null if
+      // there is no match. Otherwise, it is a new reference, counted as a
+      // font object's (see font_users).
+      loaded_face load_font_face(font_descr descr)
+      {
 #ifndef __APPLE__
-      static free_type_library ft_lib;
+         static free_type_library ft_lib;
 #endif
+         loaded_face r;
+         auto match_ptr = match(descr);
+         if (match_ptr)
+         {
+            cairo_font_face_t* handle = nullptr;
+            std::size_t bytes = 0;
+            auto [cairo_font_map, cairo_font_map_mutex] = get_cairo_font_map();
+            std::lock_guard<std::mutex> lock(cairo_font_map_mutex);
+            if (auto it = cairo_font_map.find(match_ptr->full_name); it != cairo_font_map.end())
+            {
+               it->second.last_use = next_use();
+               r.face = acquire_font_face(it->second.face);
+               r.cached = &it->second;
+            }
+            else
+            {
+#ifdef __APPLE__
 
-      auto match_ptr = match(descr);
-      if (match_ptr)
+               auto cfstr = CFStringCreateWithCString(
+                  kCFAllocatorDefault
+                , match_ptr->full_name.c_str()
+                , kCFStringEncodingUTF8
+               );
+               auto cgfont = CGFontCreateWithFontName(cfstr);
+               handle = cairo_quartz_font_face_create_for_cgfont(cgfont);
+               if (cgfont)
+                  CFRelease(cgfont);
+               if (cfstr)
+                  CFRelease(cfstr);
+#else
+               handle = ft_lib.load_font(match_ptr->file, match_ptr->index);
+               if (handle)
+               {
+                  auto data = static_cast<free_type_face_data*>(
+                     cairo_font_face_get_user_data(handle, &cairo_user_data_key()));
+                  bytes = data->file->size();
+               }
+#endif
+
+               if (handle)
+               {
+                  auto users = new std::atomic<int>{1};
+                  if (cairo_font_face_set_user_data(
+                     handle, &font_users_key(), users
+                   , [](void* p) { delete static_cast<std::atomic<int>*>(p); }
+                  ) != CAIRO_STATUS_SUCCESS)
+                  {
+                     delete users;
+                  }
+
+                  trim_font_map(cairo_font_map);
+                  auto& cached = cairo_font_map[match_ptr->full_name];
+                  cached = cached_face{cairo_font_face_reference(handle), next_use(), bytes};
+                  r.face = handle;
+                  r.cached = &cached;
+               }
+            }
+            r.generation = font_map_generation();
+         }
+         return r;
+      }
+
+      ////////////////////////////////////////////////////////////////////////
+      // Per-thread memo of the most recently resolved font descriptors. This
+      // spares the `match` (family list tokenization and font map lookup)
+      // for descriptors that are used over and over, such as the theme
+      // fonts. The memo does not hold references to the faces, so that
+      // faces no longer in use may still be released from the font map.
+      // Entries are valid only for as long as no face was released (see
+      // font_map_generation).
+      ////////////////////////////////////////////////////////////////////////
+      class resolved_fonts
       {
-         auto [cairo_font_map, cairo_font_map_mutex] = get_cairo_font_map();
-         std::lock_guard<std::mutex> lock(cairo_font_map_mutex);
-         if (auto it = cairo_font_map.find(match_ptr->full_name); it != cairo_font_map.end())
+      public:
+
+         static constexpr std::size_t capacity = 32;
+
+         struct entry
+         {
+            std::string          families;
+            std::uint8_t         weight = 0;
+            std::uint8_t         slant = 0;
+            std::uint8_t         stretch = 0;
+            loaded_face          loaded;
+         };
+
+         static resolved_fonts&  get();
+         entry*                  find(font_descr descr);
+         void                    add(font_descr descr, loaded_face loaded);
+
+      private:
+
+         void                    clear();
+
+         std::vector<entry>      _entries;
+         std::size_t             _next = 0;
+         std::uint64_t           _theme_generation = 0;
+      };
+
+      void resolved_fonts::clear()
+      {
+         _entries.clear();
+         _next = 0;
+      }
+
+      resolved_fonts& resolved_fonts::get()
+      {
+         thread_local resolved_fonts memo;
+         return memo;
+      }
+
+      resolved_fonts::entry* resolved_fonts::find(font_descr descr)
+      {
+         // Most descriptors come from the theme. Release the fonts of the
+         // previous theme when the theme changes.
+         if (auto gen = theme_generation(); gen != _theme_generation)
          {
-            _handle = cairo_font_face_reference(it->second);
+            clear();
+            _theme_generation = gen;
          }
-         else
+
+         for (auto& e : _entries)
          {
-#ifdef __APPLE__
+            if (e.weight == descr._weight && e.slant == descr._slant
+               && e.stretch == descr._stretch && e.families == descr._families)
+               return &e;
+         }
+         return nullptr;
+      }
 
-            auto cfstr = CFStringCreateWithCString(
-               kCFAllocatorDefault
-             , match_ptr->full_name.c_str()
-             , kCFStringEncodingUTF8
-            );
-            auto cgfont = CGFontCreateWithFontName(cfstr);
-            _handle = cairo_quartz_font_face_create_for_cgfont(cgfont);
-            if (cgfont)
-               CFRelease(cgfont);
-            if (cfstr)
-               CFRelease(cfstr);
-#else
-            _handle = ft_lib.load_font(match_ptr->file.c_str());
-#endif
+      void resolved_fonts::add(font_descr descr, loaded_face loaded)
+      {
+         entry e{
+            std::string{descr._families}, descr._weight, descr._slant, descr._stretch
+          , loaded
+         };
 
-            if (_handle)
-               cairo_font_map[match_ptr->full_name] = cairo_font_face_reference(_handle);
+         if (_entries.size() < capacity)
+         {
+            _entries.push_back(std::move(e));
+         }
+         else
+         {
+            // Replace the oldest entry
+            _entries[_next] = std::move(e);
+            _next = (_next + 1) % capacity;
          }
       }
-      else
+
+      // Returns a new reference to the memoized face, or nullptr if the face
+      // may have been released from the font map since it was memoized.
+      cairo_font_face_t* acquire_memoized(loaded_face const& loaded)
       {
-         _handle = nullptr;
+         auto [cairo_font_map, cairo_font_map_mutex] = get_cairo_font_map();
+         std::lock_guard<std::mutex> lock(cairo_font_map_mutex);
+         if (loaded.generation != font_map_generation())
+            return nullptr;
+         loaded.cached->last_use = next_use();
+         return acquire_font_face(loaded.face);
+      }
+   }
+
+   font::font(font_descr descr)
+   {
+      auto& memo = resolved_fonts::get();
+      auto e = memo.find(descr);
+      if (e && e->loaded.face)
+         _handle = acquire_memoized(e->loaded);
+
+      // Not memoized, or the memoized face may have been released
+      if (!e || (e->loaded.face && !_handle))
+      {
+         auto loaded = load_font_face(descr);
+         _handle = loaded.face;
+         if (e)
+            e->loaded = loaded;
+         else
+            memo.add(descr, loaded);
       }
       _size = descr._size;
    }
 
    font::font(font const& rhs)
    {
-      _handle = cairo_font_face_reference(rhs._handle);
+      _handle = rhs._handle? acquire_font_face(rhs._handle) : nullptr;
       _size = rhs._size;
    }
 
@@ -683,8 +1039,11 @@ namespace cycfi { namespace elements
    {
       if (&rhs != this)
       {
-         _handle = cairo_font_face_reference(rhs._handle);
+         auto old = _handle;
+         _handle = rhs._handle? acquire_font_face(rhs._handle) : nullptr;
          _size = rhs._size;
+         if (old)
+            release_font_face(old);
       }
       return *this;
    }
@@ -705,7 +1064,7 @@ namespace cycfi { namespace elements
    font::~font()
    {
       if (_handle)
-         cairo_font_face_destroy(_handle);
+         release_font_face(_handle);
    }
 }}
 
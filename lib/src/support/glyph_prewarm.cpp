@@ -0,0 +1,153 @@
+/*=============================================================================
+   Copyright (c) 2016-2024 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/support/glyph_prewarm.hpp>
+#include <elements/support/canvas.hpp>
+#include <elements/support/icon_ids.hpp>
+#include <elements/support/text_utils.hpp>
+#include <elements/support/theme.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace cycfi::elements
+{
+   glyph_prewarmer::glyph_prewarmer(float scale)
+   {
+      auto const& thm = get_theme();
+      auto ascii = ascii_charset();
+      for (auto const& f : {
+         thm.system_font, thm.heading_font, thm.label_font
+       , thm.text_box_font, thm.mono_spaced_font
+      })
+      {
+         add(f, ascii);
+      }
+      add(thm.icon_font, icons_charset());
+      start(scale);
+   }
+
+   glyph_prewarmer::glyph_prewarmer(
+      std::vector<font_descr> const& fonts
+    , std::string charset
+    , float scale
+   )
+   {
+      for (auto const& f : fonts)
+         add(f, charset);
+      start(scale);
+   }
+
+   glyph_prewarmer::~glyph_prewarmer()
+   {
+      _cancel = true;
+      if (_thread.joinable())
+         _thread.join();
+      for (auto sf : _scaled_fonts)
+         cairo_scaled_font_destroy(sf);
+   }
+
+   bool glyph_prewarmer::ready() const
+   {
+      return _ready;
+   }
+
+   void glyph_prewarmer::wait()
+   {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _ready_cv.wait(lock, [this]{ return _ready.load(); });
+   }
+
+   std::string glyph_prewarmer::ascii_charset()
+   {
+      std::string charset;
+      for (char ch = 0x20; ch < 0x7f; ++ch)
+         charset += ch;
+      return charset;
+   }
+
+   std::string glyph_prewarmer::icons_charset()
+   {
+      std::string charset;
+      for (auto cp : icons::all)
+         charset += codepoint_to_utf8(cp);
+      return charset;
+   }
+
+   void glyph_prewarmer::add(font_descr descr, std::string charset)
+   {
+      // Keep our own copy of the family names. The descriptor's
+      // `_families` is made to point to it in `run`.
+      _jobs.push_back(job{std::string{descr._families}, descr, std::move(charset)});
+   }
+
+   void glyph_prewarmer::start(float scale)
+   {
+      _thread = std::thread([this, scale]{ run(scale); });
+   }
+
+   void glyph_prewarmer::run(float scale)
+   {
+      for (auto& j : _jobs)
+      {
+         if (_cancel)
+            break;
+
+         auto descr = j.descr;
+         descr._families = j.families;
+         font font_{descr};
+         if (!font_)
+            continue;
+
+         // A scratch surface, large enough so that the glyphs drawn at the
+         // center are not clipped out (clipped glyphs are not rasterized).
+         int const dim = int(std::ceil(descr._size * scale * 2)) + 2;
+         auto surface = cairo_image_surface_create(CAIRO_FORMAT_A8, dim, dim);
+         auto cr = cairo_create(surface);
+         cairo_scale(cr, scale, scale);
+         {
+            canvas cnv{*cr};
+            cnv.font(font_, descr._size);
+
+            auto sf = cairo_get_scaled_font(cr);
+            cairo_glyph_t* glyphs = nullptr;
+            int num_glyphs = 0;
+            auto status = cairo_scaled_font_text_to_glyphs(
+               sf, 0, 0, j.charset.data(), int(j.charset.size())
+             , &glyphs, &num_glyphs, nullptr, nullptr, nullptr
+            );
+
+            if (status == CAIRO_STATUS_SUCCESS)
+            {
+               // Rasterize each distinct glyph once, drawn at the center
+               std::sort(glyphs, glyphs + num_glyphs,
+                  [](auto const& a, auto const& b) { return a.index < b.index; });
+               auto end = std::unique(glyphs, glyphs + num_glyphs,
+                  [](auto const& a, auto const& b) { return a.index == b.index; });
+
+               float const center = dim / (2 * scale);
+               for (auto g = glyphs; g != end && !_cancel; ++g)
+               {
+                  g->x = center - descr._size / 2;
+                  g->y = center + descr._size / 2;
+                  cairo_show_glyphs(cr, g, 1);
+               }
+               cairo_glyph_free(glyphs);
+            }
+
+            // Keep the scaled font (and its glyph cache) alive
+            _scaled_fonts.push_back(cairo_scaled_font_reference(sf));
+         }
+         cairo_destroy(cr);
+         cairo_surface_destroy(surface);
+      }
+
+      {
+         std::lock_guard<std::mutex> lock(_mutex);
+         _ready = true;
+      }
+      _ready_cv.notify_all();
+   }
+}
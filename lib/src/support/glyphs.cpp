@@ -96,11 +96,14 @@ namespace cycfi { namespace elements
       cairo_translate(cr, pos.x - _glyphs->x, pos.y - _glyphs->y);
       canvas_.apply_fill_style();
 
-      cairo_show_text_glyphs(
-         cr, _first, int(_last - _first),
-         _glyphs, _glyph_count,
-         _clusters, _cluster_count, _clusterflags
-      );
+      if (!canvas_.record_glyphs(_glyphs, _glyph_count))
+      {
+         cairo_show_text_glyphs(
+            cr, _first, int(_last - _first),
+            _glyphs, _glyph_count,
+            _clusters, _cluster_count, _clusterflags
+         );
+      }
    }
 
    float glyphs::width() const
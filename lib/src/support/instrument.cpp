@@ -0,0 +1,51 @@
+/*=============================================================================
+   Copyright (c) 2016-2024 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/support/instrument.hpp>
+
+namespace cycfi::elements
+{
+   namespace detail
+   {
+      frame_record*& active_frame_record()
+      {
+         thread_local frame_record* rec = nullptr;
+         return rec;
+      }
+   }
+
+   void frame_recorder::begin(frame_record::kind_enum kind, char const* what)
+   {
+      // Nested frames (e.g. a `layout` triggered while handling a `click`)
+      // are accumulated into the outermost record.
+      if (_depth++ != 0)
+         return;
+
+      _current = frame_record{};
+      _current.kind = kind;
+      _current.what = what;
+      _current.start = frame_record::clock::now();
+      _current.refresh_posts = _pending_refresh.exchange(0);
+
+      auto& active = detail::active_frame_record();
+      _saved = active;
+      active = &_current;
+   }
+
+   void frame_recorder::end()
+   {
+      if (_depth == 0 || --_depth != 0)
+         return;
+
+      _current.total = frame_record::clock::now() - _current.start;
+      _records[_head] = _current;
+      _head = (_head + 1) % capacity;
+      if (_size < capacity)
+         ++_size;
+
+      detail::active_frame_record() = _saved;
+      _saved = nullptr;
+   }
+}
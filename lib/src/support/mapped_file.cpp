@@ -0,0 +1,112 @@
+/*=============================================================================
+   Copyright (c) 2016-2024 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/support/detail/mapped_file.hpp>
+#include <utility>
+
+#if defined(_WIN32)
+# include <Windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+namespace cycfi::elements::detail
+{
+   mapped_file::mapped_file(fs::path const& path)
+   {
+#if defined(_WIN32)
+      auto file = CreateFileW(
+         path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr
+       , OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr
+      );
+      if (file == INVALID_HANDLE_VALUE)
+         return;
+      _file = file;
+
+      LARGE_INTEGER size;
+      if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+      {
+         close();
+         return;
+      }
+      _mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      if (_mapping)
+         _data = MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0);
+      if (!_data)
+      {
+         close();
+         return;
+      }
+      _size = std::size_t(size.QuadPart);
+#else
+      int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+      if (fd < 0)
+         return;
+      struct stat st;
+      if (::fstat(fd, &st) != 0 || st.st_size == 0)
+      {
+         ::close(fd);
+         return;
+      }
+      void* data = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      ::close(fd);
+      if (data == MAP_FAILED)
+         return;
+      _data = data;
+      _size = std::size_t(st.st_size);
+#endif
+   }
+
+   mapped_file::mapped_file(mapped_file&& rhs) noexcept
+    : _data(std::exchange(rhs._data, nullptr))
+    , _size(std::exchange(rhs._size, 0))
+#if defined(_WIN32)
+    , _file(std::exchange(rhs._file, nullptr))
+    , _mapping(std::exchange(rhs._mapping, nullptr))
+#endif
+   {
+   }
+
+   mapped_file::~mapped_file()
+   {
+      close();
+   }
+
+   mapped_file& mapped_file::operator=(mapped_file&& rhs) noexcept
+   {
+      if (this != &rhs)
+      {
+         close();
+         _data = std::exchange(rhs._data, nullptr);
+         _size = std::exchange(rhs._size, 0);
+#if defined(_WIN32)
+         _file = std::exchange(rhs._file, nullptr);
+         _mapping = std::exchange(rhs._mapping, nullptr);
+#endif
+      }
+      return *this;
+   }
+
+   void mapped_file::close()
+   {
+#if defined(_WIN32)
+      if (_data)
+         UnmapViewOfFile(_data);
+      if (_mapping)
+         CloseHandle(_mapping);
+      if (_file)
+         CloseHandle(_file);
+      _file = _mapping = nullptr;
+#else
+      if (_data)
+         ::munmap(_data, _size);
+#endif
+      _data = nullptr;
+      _size = 0;
+   }
+}
@@ -5,6 +5,8 @@
 =============================================================================*/
 #include <elements/support/pixmap.hpp>
 #include <elements/support/resource_paths.hpp>
+#include <elements/support/detail/mapped_file.hpp>
+#include <elements/support/detail/pixel_convert.hpp>
 #define STB_IMAGE_IMPLEMENTATION
 #define STBI_NO_PNG 1
 #include <webp/decode.h>
@@ -12,15 +14,213 @@
 #include <infra/assert.hpp>
 #include <infra/filesystem.hpp>
 #include <string>
-#include <fstream>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# include <emmintrin.h>
+#elif defined(__ARM_NEON)
+# include <arm_neon.h>
+#endif
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <tuple>
 
 namespace cycfi { namespace elements
 {
+   namespace
+   {
+      ////////////////////////////////////////////////////////////////////////
+      // Pixel conversion
+      //
+      // Decoders give us straight (non-premultiplied) RGBA bytes, while
+      // cairo's ARGB32 expects native-endian 32-bit words with premultiplied
+      // alpha, i.e. premultiplied BGRA bytes on little-endian machines.
+      //
+      // convert_pixels premultiplies n pixels from src to dest, swapping the
+      // red and blue channels if swap_rb is true. src and dest may be the
+      // same buffer. All code paths compute round(c * a / 255) exactly, and
+      // produce identical results.
+      ////////////////////////////////////////////////////////////////////////
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+      constexpr bool little_endian = false;
+#else
+      constexpr bool little_endian = true;
+#endif
+
+      inline uint32_t premultiply(uint32_t c, uint32_t a)
+      {
+         auto t = c * a + 128;
+         return (t + (t >> 8)) >> 8;
+      }
+
+      void convert_pixels_scalar(
+         uint8_t const* src, uint8_t* dest, std::size_t n, bool swap_rb)
+      {
+         for (std::size_t i = 0; i != n; ++i, src += 4, dest += 4)
+         {
+            uint32_t a = src[3];
+            uint32_t r = premultiply(src[swap_rb? 0 : 2], a);
+            uint32_t g = premultiply(src[1], a);
+            uint32_t b = premultiply(src[swap_rb? 2 : 0], a);
+            uint32_t px = (a << 24) | (r << 16) | (g << 8) | b;
+            std::memcpy(dest, &px, 4);    // Native-endian ARGB32
+         }
+      }
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define ELEMENTS_PIXMAP_SSE2
+      // Premultiply two pixels held as 16-bit lanes
+      inline __m128i premultiply_sse2(__m128i px, __m128i alpha_mask, bool swap_rb)
+      {
+         auto a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(px, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+         a = _mm_or_si128(a, alpha_mask);    // Leave alpha itself as is
+         auto t = _mm_add_epi16(_mm_mullo_epi16(px, a), _mm_set1_epi16(128));
+         t = _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+         if (swap_rb)
+            t = _mm_shufflehi_epi16(_mm_shufflelo_epi16(t, _MM_SHUFFLE(3, 0, 1, 2)), _MM_SHUFFLE(3, 0, 1, 2));
+         return t;
+      }
+
+      void convert_pixels(uint8_t const* src, uint8_t* dest, std::size_t n, bool swap_rb)
+      {
+         auto const zero = _mm_setzero_si128();
+         auto const alpha_mask = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+         std::size_t i = 0;
+         for (; i + 4 <= n; i += 4, src += 16, dest += 16)
+         {
+            auto px = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src));
+            auto lo = premultiply_sse2(_mm_unpacklo_epi8(px, zero), alpha_mask, swap_rb);
+            auto hi = premultiply_sse2(_mm_unpackhi_epi8(px, zero), alpha_mask, swap_rb);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), _mm_packus_epi16(lo, hi));
+         }
+         convert_pixels_scalar(src, dest, n - i, swap_rb);
+      }
+
+#elif defined(__ARM_NEON) && !(defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__))
+# define ELEMENTS_PIXMAP_NEON
+      inline uint8x8_t premultiply_neon(uint8x8_t c, uint8x8_t a)
+      {
+         auto t = vmull_u8(c, a);
+         return vrshrn_n_u16(vrsraq_n_u16(t, t, 8), 8);
+      }
+
+      void convert_pixels(uint8_t const* src, uint8_t* dest, std::size_t n, bool swap_rb)
+      {
+         std::size_t i = 0;
+         for (; i + 8 <= n; i += 8, src += 32, dest += 32)
+         {
+            auto px = vld4_u8(src);
+            auto a = px.val[3];
+            uint8x8x4_t out;
+            out.val[0] = premultiply_neon(px.val[swap_rb? 2 : 0], a);
+            out.val[1] = premultiply_neon(px.val[1], a);
+            out.val[2] = premultiply_neon(px.val[swap_rb? 0 : 2], a);
+            out.val[3] = a;
+            vst4_u8(dest, out);
+         }
+         convert_pixels_scalar(src, dest, n - i, swap_rb);
+      }
+
+#else
+      void convert_pixels(uint8_t const* src, uint8_t* dest, std::size_t n, bool swap_rb)
+      {
+         convert_pixels_scalar(src, dest, n, swap_rb);
+      }
+#endif
+
+      // Create an ARGB32 surface from straight RGBA pixels
+      cairo_surface_t* make_surface(uint8_t const* src_data, int w, int h)
+      {
+         auto surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, w, h);
+         if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS)
+         {
+            cairo_surface_destroy(surface);
+            return nullptr;
+         }
+
+         cairo_surface_flush(surface);
+         uint8_t* dest_data = cairo_image_surface_get_data(surface);
+         std::size_t src_stride = std::size_t(w) * 4;
+         std::size_t dest_stride = cairo_image_surface_get_stride(surface);
+
+         for (int y = 0; y != h; ++y)
+         {
+            convert_pixels(
+               src_data + (y * src_stride), dest_data + (y * dest_stride), w, true);
+         }
+         return surface;
+      }
+
+      // Decode a WEBP image. On little-endian machines, the image is decoded
+      // directly into the surface's pixels, as BGRA, then premultiplied in
+      // place.
+      cairo_surface_t* decode_webp(uint8_t const* data, std::size_t size)
+      {
+         int w, h;
+         if (!WebPGetInfo(data, size, &w, &h))
+            return nullptr;
+
+         if constexpr (little_endian)
+         {
+            auto surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, w, h);
+            if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS)
+            {
+               cairo_surface_destroy(surface);
+               return nullptr;
+            }
+
+            cairo_surface_flush(surface);
+            uint8_t* dest_data = cairo_image_surface_get_data(surface);
+            int dest_stride = cairo_image_surface_get_stride(surface);
+            if (!WebPDecodeBGRAInto(data, size, dest_data, std::size_t(dest_stride) * h, dest_stride))
+            {
+               cairo_surface_destroy(surface);
+               return nullptr;
+            }
+
+            for (int y = 0; y != h; ++y)
+            {
+               auto row = dest_data + (y * dest_stride);
+               convert_pixels(row, row, w, false);
+            }
+            return surface;
+         }
+         else
+         {
+            auto src_data = WebPDecodeRGBA(data, size, &w, &h);
+            if (!src_data)
+               return nullptr;
+            auto surface = make_surface(src_data, w, h);
+            WebPFree(src_data);
+            return surface;
+         }
+      }
+   }
+
+   namespace detail
+   {
+      void premultiply_pixels(uint8_t const* src, uint8_t* dest, std::size_t n, bool swap_rb)
+      {
+         convert_pixels(src, dest, n, swap_rb);
+      }
+
+      void premultiply_pixels_scalar(uint8_t const* src, uint8_t* dest, std::size_t n, bool swap_rb)
+      {
+         convert_pixels_scalar(src, dest, n, swap_rb);
+      }
+   }
+
    pixmap::pixmap(point size, float scale)
     : _surface(cairo_image_surface_create(CAIRO_FORMAT_ARGB32, size.x, size.y))
    {
-      if (!_surface)
+      if (cairo_surface_status(_surface) != CAIRO_STATUS_SUCCESS)
+      {
+         cairo_surface_destroy(_surface);
+         _surface = nullptr;
          throw failed_to_load_pixmap{"Failed to create pixmap."};
+      }
 
       // Set scale and flag the surface as dirty
       cairo_surface_set_device_scale(_surface, 1/scale, 1/scale);
@@ -38,80 +238,167 @@ namespace cycfi { namespace elements
       if (full_path.empty())
          throw failed_to_load_pixmap{"File does not exist."};
 
-      uint8_t* src_data = nullptr;
-      int w, h;
-
       if (ext == ".png" || ext == ".PNG")
       {
-         // For PNGs, use Cairo's native PNG loader
+         // For PNGs, use Cairo's native PNG loader. On failure, it returns
+         // an error surface, not null.
          _surface = cairo_image_surface_create_from_png(full_path.string().c_str());
+         if (cairo_surface_status(_surface) != CAIRO_STATUS_SUCCESS)
+         {
+            cairo_surface_destroy(_surface);
+            _surface = nullptr;
+         }
       }
-      if (ext == ".webp" || ext == ".WEBP")
+      else if (ext == ".webp" || ext == ".WEBP")
       {
-         std::ifstream file(full_path.string().c_str(), std::ios::binary);
-         if (!file.is_open())
+         // Map the file instead of reading it into memory
+         detail::mapped_file file{full_path};
+         if (!file)
             throw failed_to_load_pixmap{"Failed to open file: " + path.string()};
 
-         // Get file size
-         file.seekg(0, std::ios::end);
-         std::streamsize size = file.tellg();
-         file.seekg(0, std::ios::beg);
-
-         // Read file into memory
-         std::vector<uint8_t> data(size);
-         if (!file.read((char*)data.data(), size))
-            throw failed_to_load_pixmap{"Failed to read file: " + path.string()};
-
-         src_data = WebPDecodeRGBA(data.data(), size, &w, &h);
+         _surface = decode_webp(file.data(), file.size());
       }
       else
       {
          // For everything else, use stb_image
-         int components;
-         src_data = stbi_load(full_path.string().c_str(), &w, &h, &components, 4);
+         int w, h, components;
+         if (auto src_data = stbi_load(full_path.string().c_str(), &w, &h, &components, 4))
+         {
+            _surface = make_surface(src_data, w, h);
+            stbi_image_free(src_data);
+         }
+      }
+
+      if (!_surface)
+         throw failed_to_load_pixmap{"Failed to load pixmap."};
+
+      // Set scale and flag the surface as dirty
+      cairo_surface_set_device_scale(_surface, 1/scale, 1/scale);
+      cairo_surface_mark_dirty(_surface);
+   }
+
+   pixmap::~pixmap()
+   {
+      clear_mips();
+      if (_surface)
+         cairo_surface_destroy(_surface);
+   }
+
+   struct pixmap::mip_chain
+   {
+      // levels[i] is level i+1: the pixmap halved i+1 times
+      std::vector<cairo_surface_t*> levels;
+   };
+
+   namespace
+   {
+      // Pixmaps can be shared across threads. Mip generation is rare, so a
+      // single lock for all pixmaps will do.
+      std::mutex& mips_mutex()
+      {
+         static std::mutex mutex;
+         return mutex;
       }
 
-      if (src_data)
+      // Box filter (2x2 average) of premultiplied ARGB32 pixels. Odd
+      // trailing rows and columns are averaged with themselves.
+      cairo_surface_t* halve(cairo_surface_t* src)
       {
-         _surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, w, h);
+         cairo_surface_flush(src);
+         int const sw = cairo_image_surface_get_width(src);
+         int const sh = cairo_image_surface_get_height(src);
+         int const dw = std::max(1, (sw + 1) / 2);
+         int const dh = std::max(1, (sh + 1) / 2);
 
-         uint8_t* dest_data = cairo_image_surface_get_data(_surface);
-         size_t   src_stride = w * 4;
-         size_t   dest_stride = cairo_image_surface_get_stride(_surface);
+         auto dest = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, dw, dh);
+         if (cairo_surface_status(dest) != CAIRO_STATUS_SUCCESS)
+         {
+            cairo_surface_destroy(dest);
+            return nullptr;
+         }
+         cairo_surface_flush(dest);
 
-         for (int y = 0; y != h; ++y)
+         auto const src_data = cairo_image_surface_get_data(src);
+         auto const src_stride = cairo_image_surface_get_stride(src);
+         auto const dest_data = cairo_image_surface_get_data(dest);
+         auto const dest_stride = cairo_image_surface_get_stride(dest);
+
+         for (int y = 0; y != dh; ++y)
          {
-            uint8_t* src = src_data + (y * src_stride);
-            uint8_t* dest = dest_data + (y * dest_stride);
-            for (int x = 0; x != w; ++x)
-            {
-               // $$$ TODO: Deal with endian issues $$$
+            auto row0 = reinterpret_cast<uint32_t const*>(src_data + (2 * y * src_stride));
+            auto row1 = reinterpret_cast<uint32_t const*>(
+               src_data + (std::min(2 * y + 1, sh - 1) * src_stride));
+            auto out = reinterpret_cast<uint32_t*>(dest_data + (y * dest_stride));
 
-               dest[0] = src[2];    // blue
-               dest[1] = src[1];    // green
-               dest[2] = src[0];    // red
-               dest[3] = src[3];    // alpha
+            for (int x = 0; x != dw; ++x)
+            {
+               int const x0 = 2 * x;
+               int const x1 = std::min(x0 + 1, sw - 1);
+               uint32_t const p[] = {row0[x0], row0[x1], row1[x0], row1[x1]};
 
-               src += 4;
-               dest += 4;
+               // Average the 4 channels in 2 lanes of 16 bits each
+               uint32_t rb = 0x00020002, ag = 0x00020002;
+               for (auto px : p)
+               {
+                  rb += px & 0x00ff00ff;
+                  ag += (px >> 8) & 0x00ff00ff;
+               }
+               out[x] = ((rb >> 2) & 0x00ff00ff) | (((ag >> 2) & 0x00ff00ff) << 8);
             }
          }
 
-         free(src_data);
+         cairo_surface_mark_dirty(dest);
+         return dest;
       }
+   }
 
-      if (!_surface)
-         throw failed_to_load_pixmap{"Failed to load pixmap."};
+   cairo_surface_t* pixmap::level(float pixel_ratio) const
+   {
+      // The number of halvings that keeps the level at least as large as
+      // the destination (in device pixels)
+      int n = 0;
+      for (float r = pixel_ratio; r <= 0.5f && n < _max_level; r *= 2)
+         ++n;
+      if (n == 0 || cairo_surface_get_type(_surface) != CAIRO_SURFACE_TYPE_IMAGE)
+         return _surface;
 
-      // Set scale and flag the surface as dirty
-      cairo_surface_set_device_scale(_surface, 1/scale, 1/scale);
-      cairo_surface_mark_dirty(_surface);
+      std::lock_guard<std::mutex> lock(mips_mutex());
+      auto& self = const_cast<pixmap&>(*this);
+      if (!self._mips)
+         self._mips = new mip_chain;
+      auto& levels = self._mips->levels;
+
+      while (int(levels.size()) < n)
+      {
+         auto prev = levels.empty()? _surface : levels.back();
+         if (cairo_image_surface_get_width(prev) == 1 && cairo_image_surface_get_height(prev) == 1)
+            break;
+         auto next = halve(prev);
+         if (!next)
+            break;
+
+         // Keep the pixmap's logical size
+         double scx, scy;
+         cairo_surface_get_device_scale(_surface, &scx, &scy);
+         cairo_surface_set_device_scale(next
+          , scx * cairo_image_surface_get_width(next) / cairo_image_surface_get_width(_surface)
+          , scy * cairo_image_surface_get_height(next) / cairo_image_surface_get_height(_surface)
+         );
+         levels.push_back(next);
+      }
+      return levels.empty()? _surface : levels[std::min<std::size_t>(n, levels.size()) - 1];
    }
 
-   pixmap::~pixmap()
+   void pixmap::clear_mips()
    {
-      if (_surface)
-         cairo_surface_destroy(_surface);
+      std::lock_guard<std::mutex> lock(mips_mutex());
+      if (_mips)
+      {
+         for (auto level : _mips->levels)
+            cairo_surface_destroy(level);
+         delete _mips;
+         _mips = nullptr;
+      }
    }
 
    extent pixmap::size() const
@@ -134,5 +421,149 @@ namespace cycfi { namespace elements
    void pixmap::scale(float val)
    {
       cairo_surface_set_device_scale(_surface, 1/val, 1/val);
+      clear_mips();
+   }
+
+   namespace
+   {
+      class pixmap_cache
+      {
+      public:
+
+         pixmap_ptr           load(fs::path const& path, float scale);
+         pixmap_ptr           find(fs::path const& path, float scale);
+         pixmap_cache_stats   stats();
+
+      private:
+
+         using file_time = fs::file_time_type;
+         using key_type = std::tuple<std::string, float, file_time>;
+         using map_type = std::map<key_type, std::weak_ptr<pixmap>>;
+
+         static key_type      make_key(fs::path const& full_path, float scale);
+         void                 prune();
+
+         std::mutex           _mutex;
+         map_type             _map;
+         std::size_t          _hits = 0;
+         std::size_t          _misses = 0;
+      };
+
+      pixmap_cache& get_pixmap_cache()
+      {
+         static pixmap_cache cache;
+         return cache;
+      }
+
+      pixmap_cache::key_type pixmap_cache::make_key(fs::path const& full_path, float scale)
+      {
+         std::error_code ec;
+         auto canonical = fs::canonical(full_path, ec);
+         if (ec)
+            canonical = full_path;
+         auto mtime = fs::last_write_time(canonical, ec);
+         if (ec)
+            mtime = {};
+         return {canonical.string(), scale, mtime};
+      }
+
+      pixmap_ptr pixmap_cache::find(fs::path const& path, float scale)
+      {
+         fs::path full_path = find_file(path);
+         if (full_path.empty())
+            return {};
+
+         auto key = make_key(full_path, scale);
+         std::lock_guard<std::mutex> lock(_mutex);
+         if (auto i = _map.find(key); i != _map.end())
+         {
+            if (auto pm = i->second.lock())
+            {
+               ++_hits;
+               return pm;
+            }
+         }
+         return {};
+      }
+
+      pixmap_ptr pixmap_cache::load(fs::path const& path, float scale)
+      {
+         fs::path full_path = find_file(path);
+         if (full_path.empty())
+            throw failed_to_load_pixmap{"File does not exist."};
+
+         auto key = make_key(full_path, scale);
+         {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (auto i = _map.find(key); i != _map.end())
+            {
+               if (auto pm = i->second.lock())
+               {
+                  ++_hits;
+                  return pm;
+               }
+            }
+            ++_misses;
+         }
+
+         // Decode outside the lock. If another thread loads the same image
+         // at the same time, the last one in wins the cache entry.
+         auto pm = std::make_shared<pixmap>(full_path, scale);
+
+         std::lock_guard<std::mutex> lock(_mutex);
+         prune();
+         _map[key] = pm;
+         return pm;
+      }
+
+      // Remove the entries of the pixmaps that are no longer alive
+      void pixmap_cache::prune()
+      {
+         for (auto i = _map.begin(); i != _map.end();)
+         {
+            if (i->second.expired())
+               i = _map.erase(i);
+            else
+               ++i;
+         }
+      }
+
+      pixmap_cache_stats pixmap_cache::stats()
+      {
+         std::lock_guard<std::mutex> lock(_mutex);
+         pixmap_cache_stats r;
+         r.hits = _hits;
+         r.misses = _misses;
+         for (auto const& [key, ptr] : _map)
+         {
+            if (auto pm = ptr.lock())
+            {
+               ++r.entries;
+               r.bytes += pm->bytes();
+            }
+         }
+         return r;
+      }
+   }
+
+   std::size_t pixmap::bytes() const
+   {
+      return std::size_t(cairo_image_surface_get_stride(_surface))
+         * cairo_image_surface_get_height(_surface);
+   }
+
+   pixmap_ptr load_pixmap(fs::path const& path, float scale)
+   {
+      return get_pixmap_cache().load(path, scale);
+   }
+
+   pixmap_ptr find_pixmap(fs::path const& path, float scale)
+   {
+      return get_pixmap_cache().find(path, scale);
+   }
+
+   pixmap_cache_stats pixmap_cache_statistics()
+   {
+      return get_pixmap_cache().stats();
    }
 }}
@@ -0,0 +1,230 @@
+/*=============================================================================
+   Copyright (c) 2016-2024 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/support/pixmap_atlas.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+namespace cycfi::elements
+{
+   pixmap_atlas::pixmap_atlas(int page_size, int padding, int mip_levels)
+    : _page_size(page_size)
+    , _padding(padding)
+    , _mip_levels(std::max(mip_levels, 0))
+   {
+   }
+
+   std::size_t pixmap_atlas::add(fs::path const& path, float scale)
+   {
+      _items.push_back(item{path, scale, {}});
+      return _items.size() - 1;
+   }
+
+   atlas_region const& pixmap_atlas::operator[](std::size_t i) const
+   {
+      if (!_items[i].region.pixmap)
+         throw std::runtime_error{"Error: pixmap_atlas is not built."};
+      return _items[i].region;
+   }
+
+   atlas_region const& pixmap_atlas::get(fs::path const& path, float scale) const
+   {
+      for (std::size_t i = 0; i != _items.size(); ++i)
+      {
+         if (_items[i].path == path && _items[i].scale == scale)
+            return (*this)[i];
+      }
+      throw std::runtime_error{"Error: Image not in pixmap_atlas: " + path.string()};
+   }
+
+   namespace
+   {
+      struct placement
+      {
+         std::size_t       index;      // Index to the atlas items
+         cairo_surface_t*  surface;
+         int               w, h;
+         int               x = 0, y = 0;
+         std::size_t       page = 0;
+      };
+
+      int align_up(int n, int align)
+      {
+         return ((n + align - 1) / align) * align;
+      }
+
+      // Shelf packing of the placements (sorted by decreasing height) into
+      // pages. Slots are multiples of `align` in size, with a gutter of
+      // `padding` (itself a multiple of `align`) around each image, so the
+      // images start at multiples of `align`. Returns the size of each page.
+      std::vector<point> pack(
+         std::vector<placement>& places, int page_size, int padding, int align)
+      {
+         std::vector<point> page_sizes;
+         int x = 0, y = 0, shelf_h = 0;
+         bool has_page = false;
+
+         for (auto& p : places)
+         {
+            int const w = align_up(p.w, align) + 2 * padding;
+            int const h = align_up(p.h, align) + 2 * padding;
+
+            if (w > page_size || h > page_size)
+            {
+               // Too big: give it a page of its own
+               p.page = page_sizes.size();
+               p.x = padding;
+               p.y = padding;
+               page_sizes.push_back(point(w, h));
+               has_page = false;
+               continue;
+            }
+
+            if (has_page && x + w > page_size)
+            {
+               // Next shelf
+               y += shelf_h;
+               x = 0;
+               shelf_h = 0;
+            }
+
+            if (!has_page || y + h > page_size)
+            {
+               // Next page
+               page_sizes.push_back(point(0, 0));
+               x = y = shelf_h = 0;
+               has_page = true;
+            }
+
+            auto& size = page_sizes.back();
+            p.page = page_sizes.size() - 1;
+            p.x = x + padding;
+            p.y = y + padding;
+            x += w;
+            shelf_h = std::max(shelf_h, h);
+            size.x = std::max<float>(size.x, x);
+            size.y = std::max<float>(size.y, y + shelf_h);
+         }
+         return page_sizes;
+      }
+
+      // Fill the gutter around the image at (x, y) with copies of its edge
+      // pixels, so that filtering at the image's edges sees no transparent
+      // or foreign pixels.
+      void extend_edges(
+         std::uint8_t* data, int stride, int x, int y, int w, int h, int gutter)
+      {
+         for (int row = y; row != y + h; ++row)
+         {
+            auto px = reinterpret_cast<std::uint32_t*>(data + (row * stride));
+            std::fill(px + x - gutter, px + x, px[x]);
+            std::fill(px + x + w, px + x + w + gutter, px[x + w - 1]);
+         }
+
+         auto const span = std::size_t(w + 2 * gutter) * 4;
+         auto const first = data + (y * stride) + ((x - gutter) * 4);
+         auto const last = data + ((y + h - 1) * stride) + ((x - gutter) * 4);
+         for (int i = 1; i <= gutter; ++i)
+         {
+            std::memcpy(first - (i * stride), first, span);
+            std::memcpy(last + (i * stride), last, span);
+         }
+      }
+   }
+
+   void pixmap_atlas::build()
+   {
+      _pages.clear();
+
+      // Load the images, grouped by scale. Each scale gets its own pages.
+      std::vector<float> scales;
+      for (auto const& i : _items)
+      {
+         if (std::find(scales.begin(), scales.end(), i.scale) == scales.end())
+            scales.push_back(i.scale);
+      }
+
+      std::vector<pixmap_ptr> sources(_items.size());
+      for (auto scale : scales)
+      {
+         std::vector<placement> places;
+         for (std::size_t i = 0; i != _items.size(); ++i)
+         {
+            if (_items[i].scale != scale)
+               continue;
+            sources[i] = load_pixmap(_items[i].path, scale);
+            auto surface = sources[i]->_surface;
+            cairo_surface_flush(surface);
+            places.push_back(placement{
+               i, surface
+             , cairo_image_surface_get_width(surface)
+             , cairo_image_surface_get_height(surface)
+            });
+         }
+
+         std::stable_sort(places.begin(), places.end(),
+            [](auto const& a, auto const& b) { return a.h > b.h; });
+
+         // Image origins are aligned to, and gutters are at least, one
+         // pixel of the deepest mip level used, so that level's pixels
+         // never straddle two images.
+         int const align = 1 << _mip_levels;
+         int const gutter = align_up(std::max(_padding, align), align);
+
+         auto const first_page = _pages.size();
+         for (auto size : pack(places, _page_size, gutter, align))
+         {
+            auto pm = std::make_shared<pixmap>(size, scale);
+            pm->_max_level = _mip_levels;
+            cairo_surface_flush(pm->_surface);
+            auto data = cairo_image_surface_get_data(pm->_surface);
+            auto stride = cairo_image_surface_get_stride(pm->_surface);
+            std::memset(data, 0, std::size_t(stride) * int(size.y));
+            _pages.push_back(pm);
+         }
+
+         // Copy the images into their pages
+         for (auto const& p : places)
+         {
+            auto& page = _pages[first_page + p.page];
+            auto dest = cairo_image_surface_get_data(page->_surface);
+            auto dest_stride = cairo_image_surface_get_stride(page->_surface);
+            auto src = cairo_image_surface_get_data(p.surface);
+            auto src_stride = cairo_image_surface_get_stride(p.surface);
+
+            bool const opaque = cairo_image_surface_get_format(p.surface) == CAIRO_FORMAT_RGB24;
+            for (int y = 0; y != p.h; ++y)
+            {
+               auto row = dest + ((p.y + y) * dest_stride) + (p.x * 4);
+               std::memcpy(row, src + (y * src_stride), std::size_t(p.w) * 4);
+               if (opaque)
+               {
+                  // RGB24 leaves the alpha byte undefined
+                  auto px = reinterpret_cast<std::uint32_t*>(row);
+                  for (int x = 0; x != p.w; ++x)
+                     px[x] |= 0xff000000;
+               }
+            }
+            extend_edges(dest, dest_stride, p.x, p.y, p.w, p.h, gutter);
+
+            // Convert to the page's logical coordinates
+            double scx, scy;
+            cairo_surface_get_device_scale(page->_surface, &scx, &scy);
+            _items[p.index].region = atlas_region{
+               page
+             , rect{
+                  float(p.x / scx), float(p.y / scy)
+                , float((p.x + p.w) / scx), float((p.y + p.h) / scy)
+               }
+            };
+         }
+      }
+
+      for (auto& page : _pages)
+         cairo_surface_mark_dirty(page->_surface);
+   }
+}
@@ -0,0 +1,208 @@
+/*=============================================================================
+   Copyright (c) 2016-2024 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/support/profiler.hpp>
+#include <elements/element/element.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <ostream>
+
+namespace cycfi::elements
+{
+   namespace
+   {
+      std::string short_name(std::string name)
+      {
+         std::string_view const prefix = "cycfi::elements::";
+         for (auto i = name.find(prefix); i != std::string::npos; i = name.find(prefix, i))
+            name.erase(i, prefix.size());
+         return name;
+      }
+
+      char const* kind_name(dispatch_kind kind)
+      {
+         switch (kind)
+         {
+            case dispatch_kind::draw: return "draw";
+            case dispatch_kind::limits: return "limits";
+            case dispatch_kind::layout: return "layout";
+         }
+         return "";
+      }
+
+      void write_json_string(std::ostream& out, std::string const& s)
+      {
+         out << '"';
+         for (char c : s)
+         {
+            if (c == '"' || c == '\\')
+               out << '\\';
+            out << c;
+         }
+         out << '"';
+      }
+
+      double to_us(profiler::duration d)
+      {
+         return std::chrono::duration<double, std::micro>(d).count();
+      }
+   }
+
+   profiler::profiler()
+   {
+      // Trace events are tagged with a per-thread id, numbered in the
+      // order the threads first use their profiler.
+      static std::atomic<std::uint32_t> next_thread_id{1};
+      _thread_id = next_thread_id++;
+   }
+
+   profiler& profiler::get()
+   {
+      thread_local profiler instance;
+      return instance;
+   }
+
+   void profiler::reset()
+   {
+      _epoch = clock::now();
+      _type_map.clear();
+      _types.clear();
+      _node_map.clear();
+      _nodes.clear();
+      _stack.clear();
+      _events.clear();
+   }
+
+   std::size_t profiler::type_of(element const& e)
+   {
+      auto [i, inserted] = _type_map.try_emplace(std::type_index(typeid(e)), _types.size());
+      if (inserted)
+         _types.push_back({short_name(e.class_name()), {}});
+      return i->second;
+   }
+
+   std::size_t profiler::node_of(std::size_t parent, element const& e, std::size_t index)
+   {
+      auto type = type_of(e);
+      auto [i, inserted] = _node_map.try_emplace(node_key{parent, index, type}, _nodes.size());
+      if (inserted)
+      {
+         std::string path;
+         if (parent != npos)
+            path = _nodes[parent].path + '/';
+         path += _types[type].name;
+         if (parent != npos)
+            path += '[' + std::to_string(index) + ']';
+         _nodes.push_back({parent, type, std::move(path), {}});
+      }
+      return i->second;
+   }
+
+   bool profiler::begin(dispatch_kind kind, element const& e, std::size_t index)
+   {
+      if (!_enabled)
+         return false;
+      auto parent = _stack.empty()? npos : _stack.back().node;
+      _stack.push_back({kind, node_of(parent, e, index), clock::now()});
+      return true;
+   }
+
+   void profiler::end()
+   {
+      // The stack may have been cleared by a reset in the middle of a call
+      if (_stack.empty())
+         return;
+
+      auto f = _stack.back();
+      _stack.pop_back();
+
+      auto const inclusive = clock::now() - f.start;
+      auto const k = std::size_t(f.kind);
+      auto& n = _nodes[f.node];
+      auto& t = _types[n.type].data;
+
+      ++n.data.calls[k];
+      n.data.inclusive[k] += inclusive;
+      n.data.exclusive[k] += inclusive - f.children;
+
+      // Recursive calls on the same type (e.g. nested tiles) must not count
+      // the inclusive time twice.
+      ++t.calls[k];
+      bool const nested = std::any_of(_stack.begin(), _stack.end(),
+         [&](frame const& outer) { return outer.kind == f.kind && _nodes[outer.node].type == n.type; }
+      );
+      if (!nested)
+         t.inclusive[k] += inclusive;
+      t.exclusive[k] += inclusive - f.children;
+
+      if (!_stack.empty())
+         _stack.back().children += inclusive;
+
+      if (_events.size() < _max_events)
+         _events.push_back({f.kind, f.node, f.start, inclusive});
+   }
+
+   std::vector<profiler::entry> profiler::types() const
+   {
+      return _types;
+   }
+
+   std::vector<profiler::entry> profiler::paths() const
+   {
+      std::vector<entry> r;
+      r.reserve(_nodes.size());
+      for (auto const& n : _nodes)
+         r.push_back({n.path, n.data});
+      return r;
+   }
+
+   void profiler::write_trace(std::ostream& out) const
+   {
+      out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+      bool first = true;
+      for (auto const& ev : _events)
+      {
+         auto const& n = _nodes[ev.node];
+         if (!first)
+            out << ',';
+         first = false;
+         out << "\n{\"name\":";
+         write_json_string(out, _types[n.type].name);
+         out << ",\"cat\":\"" << kind_name(ev.kind) << '"'
+             << ",\"ph\":\"X\""
+             << ",\"ts\":" << to_us(ev.start - _epoch)
+             << ",\"dur\":" << to_us(ev.dur)
+             << ",\"pid\":1,\"tid\":" << _thread_id
+             << ",\"args\":{\"path\":";
+         write_json_string(out, n.path);
+         out << "}}";
+      }
+      out << "\n]}\n";
+   }
+
+   bool profiler::save_trace(fs::path const& path) const
+   {
+      std::ofstream file(path);
+      if (!file)
+         return false;
+      write_trace(file);
+      return bool(file);
+   }
+
+   namespace detail
+   {
+      bool profile_begin(dispatch_kind kind, element const& e, std::size_t index)
+      {
+         return profiler::get().begin(kind, e, index);
+      }
+
+      void profile_end()
+      {
+         profiler::get().end();
+      }
+   }
+}
@@ -6,6 +6,10 @@
 #include <elements/support/theme.hpp>
 #include <elements/element/dial.hpp>
 #include <elements/view.hpp>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
 
 namespace cycfi::elements
 {
@@ -98,6 +102,58 @@ namespace cycfi::elements
       return thm;
    }
 
+   namespace
+   {
+      struct theme_change_hooks
+      {
+         using hooks_type = std::vector<std::pair<std::size_t, theme_change_function>>;
+
+         std::mutex                 mutex;
+         hooks_type                 hooks;
+         std::size_t                next_id = 0;
+         std::atomic<std::uint64_t> generation{0};
+      };
+
+      theme_change_hooks& get_theme_change_hooks()
+      {
+         static theme_change_hooks hooks;
+         return hooks;
+      }
+   }
+
+   void global_theme::_changed()
+   {
+      auto& h = get_theme_change_hooks();
+      std::lock_guard<std::mutex> lock(h.mutex);
+      auto gen = ++h.generation;
+      for (auto const& [id, f] : h.hooks)
+         f(gen);
+   }
+
+   std::uint64_t theme_generation()
+   {
+      return get_theme_change_hooks().generation.load(std::memory_order_acquire);
+   }
+
+   std::size_t on_theme_change(theme_change_function f)
+   {
+      auto& h = get_theme_change_hooks();
+      std::lock_guard<std::mutex> lock(h.mutex);
+      auto id = ++h.next_id;
+      h.hooks.emplace_back(id, std::move(f));
+      return id;
+   }
+
+   void remove_on_theme_change(std::size_t id)
+   {
+      auto& h = get_theme_change_hooks();
+      std::lock_guard<std::mutex> lock(h.mutex);
+      auto i = std::find_if(h.hooks.begin(), h.hooks.end(),
+         [id](auto const& entry) { return entry.first == id; });
+      if (i != h.hooks.end())
+         h.hooks.erase(i);
+   }
+
    theme const& get_theme()
    {
       return global_theme::_theme();
@@ -106,5 +162,6 @@ namespace cycfi::elements
    void set_theme(theme const& thm)
    {
       global_theme::_theme() = thm;
+      global_theme::_changed();
    }
 }
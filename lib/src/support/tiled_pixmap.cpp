@@ -0,0 +1,279 @@
+/*=============================================================================
+   Copyright (c) 2016-2024 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/support/tiled_pixmap.hpp>
+#include <elements/support/resource_paths.hpp>
+#include <webp/decode.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace cycfi::elements
+{
+   tiled_pixmap::tiled_pixmap(
+      fs::path const& path
+    , float scale
+    , std::size_t cache_limit
+    , int tile_size
+   )
+    : _scale(scale)
+    , _cache_limit(cache_limit)
+    , _tile_size(tile_size)
+   {
+      auto ext = path.extension();
+      if (ext == ".webp" || ext == ".WEBP")
+      {
+         fs::path full_path = find_file(path);
+         if (full_path.empty())
+            throw failed_to_load_pixmap{"File does not exist."};
+
+         _file = detail::mapped_file{full_path};
+         if (!_file)
+            throw failed_to_load_pixmap{"Failed to open file: " + path.string()};
+
+         WebPBitstreamFeatures features;
+         if (WebPGetFeatures(_file.data(), _file.size(), &features) != VP8_STATUS_OK
+            || features.has_animation)
+            throw failed_to_load_pixmap{"Failed to load pixmap."};
+         _width = features.width;
+         _height = features.height;
+
+         while ((_tile_size << _overview_level) < std::max(_width, _height))
+            ++_overview_level;
+      }
+      else
+      {
+         try
+         {
+            _whole = load_pixmap(path, scale);
+         }
+         catch (failed_to_load_pixmap const& e)
+         {
+            throw failed_to_load_pixmap{
+               "Failed to load " + path.string() + " (" + e.what() + "). Only WEBP"
+               " images (up to 16383 x 16383 pixels) are decoded in tiles. Other"
+               " formats are loaded whole, and must fit in a single image of at"
+               " most 32767 x 32767 pixels."
+            };
+         }
+      }
+   }
+
+   extent tiled_pixmap::size() const
+   {
+      if (_whole)
+         return _whole->size();
+      return {_width * _scale, _height * _scale};
+   }
+
+   std::size_t tiled_pixmap::cache_bytes() const
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      return _cache_bytes;
+   }
+
+   void tiled_pixmap::clear_cache()
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _cache.clear();
+      _cache_bytes = 0;
+   }
+
+   std::vector<tiled_pixmap::tile> tiled_pixmap::tiles(rect area, float pixel_ratio) const
+   {
+      if (_whole)
+      {
+         auto s = _whole->size();
+         auto bounds = rect{0, 0, s.x, s.y};
+         return {tile{_whole, bounds, bounds}};
+      }
+
+      // The number of halvings that keeps the level at least as large as
+      // the destination (in device pixels)
+      int level = 0;
+      for (float r = pixel_ratio; r <= 0.5f && level < _overview_level; r *= 2)
+         ++level;
+
+      // The tile grid, in full resolution pixels
+      auto const span = _tile_size << level;
+      auto const to_px = [this](float v, int max) { return std::clamp(int(v / _scale), 0, max); };
+      auto const col0 = to_px(area.left, _width) / span;
+      auto const row0 = to_px(area.top, _height) / span;
+      auto const col1 = (to_px(std::ceil(area.right), _width) + span - 1) / span;
+      auto const row1 = (to_px(std::ceil(area.bottom), _height) + span - 1) / span;
+
+      // Cached tiles go to result. Missing tiles are queued, and the cached
+      // tiles of the nearest coarser level that cover them go to stand_ins.
+      std::vector<tile> result, stand_ins;
+      std::lock_guard<std::mutex> lock(_mutex);
+      auto const keep_from = _use_count + 1;
+      bool missing = false;
+      for (int row = row0; row < row1; ++row)
+      {
+         for (int col = col0; col < col1; ++col)
+         {
+            if (auto i = _cache.find({level, col, row}); i != _cache.end())
+            {
+               i->second.last_use = ++_use_count;
+               result.push_back(i->second.tile_);
+               continue;
+            }
+
+            want({level, col, row});
+            missing = true;
+            for (int k = 1; level + k <= _overview_level; ++k)
+            {
+               auto i = _cache.find({level + k, col >> k, row >> k});
+               if (i != _cache.end())
+               {
+                  i->second.last_use = ++_use_count;
+                  auto stand_in = i->second.tile_;
+                  auto x = col * span;
+                  auto y = row * span;
+                  stand_in.area = rect{
+                     x * _scale, y * _scale
+                   , std::min(x + span, _width) * _scale, std::min(y + span, _height) * _scale
+                  };
+                  stand_ins.push_back(stand_in);
+                  break;
+               }
+            }
+         }
+      }
+
+      // Queue the overview too, so there is always something to stand in
+      if (missing && level < _overview_level)
+         want({_overview_level, 0, 0});
+
+      trim(keep_from);
+      stand_ins.insert(stand_ins.end(), result.begin(), result.end());
+      return stand_ins;
+   }
+
+   // Queue a tile for decoding. The overview goes first. Call with the
+   // mutex locked.
+   void tiled_pixmap::want(key_type key) const
+   {
+      if (_cache.count(key) || std::find(_wanted.begin(), _wanted.end(), key) != _wanted.end())
+         return;
+      if (std::get<0>(key) == _overview_level)
+         _wanted.insert(_wanted.begin(), key);
+      else
+         _wanted.push_back(key);
+   }
+
+   bool tiled_pixmap::request_decode() const
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (_decoding || _wanted.empty())
+         return false;
+      _decoding = true;
+      return true;
+   }
+
+   void tiled_pixmap::decode_wanted(std::size_t max_tiles) const
+   {
+      for (std::size_t n = 0; ; ++n)
+      {
+         key_type key;
+         {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_wanted.empty() || n == max_tiles)
+            {
+               _decoding = false;
+               return;
+            }
+            key = _wanted.front();
+            _wanted.erase(_wanted.begin());
+         }
+
+         // Decode without holding the lock, so drawing is never blocked
+         auto [level, col, row] = key;
+         rect bounds;
+         auto pm = decode(level, col, row, bounds);
+
+         std::lock_guard<std::mutex> lock(_mutex);
+         if (pm && !_cache.count(key))
+         {
+            _cache_bytes += pm->bytes();
+            _cache.emplace(key, entry{tile{pm, bounds, bounds}, ++_use_count});
+            trim(_use_count);
+         }
+      }
+   }
+
+   // Evict the least recently used tiles, except the ones used from
+   // `keep_from` on, until we are within the cache limit.
+   void tiled_pixmap::trim(std::uint64_t keep_from) const
+   {
+      while (_cache_bytes > _cache_limit)
+      {
+         auto lru = std::min_element(_cache.begin(), _cache.end(),
+            [](auto const& a, auto const& b) { return a.second.last_use < b.second.last_use; });
+         if (lru == _cache.end() || lru->second.last_use >= keep_from)
+            break;
+         _cache_bytes -= lru->second.tile_.pixmap->bytes();
+         _cache.erase(lru);
+      }
+   }
+
+   pixmap_ptr tiled_pixmap::decode(int level, int col, int row, rect& bounds) const
+   {
+      // The tile's region, in full resolution pixels
+      int const span = _tile_size << level;
+      int const x = col * span;
+      int const y = row * span;
+      int const w = std::min(span, _width - x);
+      int const h = std::min(span, _height - y);
+      if (w <= 0 || h <= 0)
+         return {};
+
+      // The tile's size, in pixels, at the given level
+      int const tw = std::max(1, (w + (1 << level) - 1) >> level);
+      int const th = std::max(1, (h + (1 << level) - 1) >> level);
+
+      auto pm = std::make_shared<pixmap>(point(tw, th));
+      auto surface = pm->_surface;
+      cairo_surface_flush(surface);
+
+      WebPDecoderConfig config;
+      if (!WebPInitDecoderConfig(&config))
+         return {};
+      config.options.use_cropping = 1;
+      config.options.crop_left = x;
+      config.options.crop_top = y;
+      config.options.crop_width = w;
+      config.options.crop_height = h;
+      if (level > 0)
+      {
+         config.options.use_scaling = 1;
+         config.options.scaled_width = tw;
+         config.options.scaled_height = th;
+      }
+
+      // Decode directly into the tile's pixels, premultiplied, in cairo's
+      // native-endian ARGB32 layout
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+      config.output.colorspace = MODE_Argb;
+#else
+      config.output.colorspace = MODE_bgrA;
+#endif
+      config.output.is_external_memory = 1;
+      config.output.u.RGBA.rgba = cairo_image_surface_get_data(surface);
+      config.output.u.RGBA.stride = cairo_image_surface_get_stride(surface);
+      config.output.u.RGBA.size = std::size_t(config.output.u.RGBA.stride) * th;
+
+      auto status = WebPDecode(_file.data(), _file.size(), &config);
+      WebPFreeDecBuffer(&config.output);
+      if (status != VP8_STATUS_OK)
+         return {};
+      cairo_surface_mark_dirty(surface);
+
+      // Map the tile's pixels to the tiled_pixmap's logical coordinates
+      bounds = rect{x * _scale, y * _scale, (x + w) * _scale, (y + h) * _scale};
+      pm->scale(bounds.width() / tw);
+      return pm;
+   }
+}
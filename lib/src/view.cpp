@@ -6,6 +6,8 @@
 #include <elements/view.hpp>
 #include <elements/window.hpp>
 #include <elements/support/context.hpp>
+#include <elements/support/instrument.hpp>
+#include <iostream>
 
  namespace cycfi::elements
  {
@@ -13,13 +15,17 @@
     : base_view(size_)
     , _main_element(make_scaled_content())
     , _work(_io)
-   {}
+   {
+      track_theme();
+   }
 
    view::view(host_view_handle h)
     : base_view(h)
     , _main_element(make_scaled_content())
     , _work(_io)
-   {}
+   {
+      track_theme();
+   }
 
    view::view(window& win)
     : base_view(win.host())
@@ -31,25 +37,62 @@
          win.limits(limits_);
       };
       win.limits(_current_limits);
+      track_theme();
    }
 
    view::~view()
    {
+      {
+         std::lock_guard<std::mutex> lock(_async_target->mutex);
+         _async_target->self = nullptr;
+      }
+      remove_on_theme_change(_theme_hook);
+      for (auto m : _models)
+         m->_view = nullptr;
       _io.stop();
    }
 
+   void view::track_theme()
+   {
+      // A theme change may affect the limits and looks of any element.
+      // Theme changes often come in bunches (e.g. override_theme for
+      // several members), so we coalesce them into a single relayout and
+      // redraw, done in the view's thread.
+      _theme_hook = on_theme_change(
+         [this](std::uint64_t /* generation */)
+         {
+            if (!_theme_changed.exchange(true))
+            {
+               _io.post(
+                  [this]
+                  {
+                     _theme_changed = false;
+                     set_limits();
+                     layout();
+                  }
+               );
+            }
+         }
+      );
+   }
+
    void view::set_limits()
    {
       if (_content.empty())
          return;
 
+      ELEMENTS_INSTRUMENT_PHASE(set_limits);
       auto surface_ = cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, nullptr);
       auto context_ = cairo_create(surface_);
       canvas cnv{*context_};
 
       // Update the limits and constrain the window size to the limits
       basic_context bctx{*this, cnv};
-      auto limits_ = _main_element.limits(bctx);
+      view_limits limits_;
+      {
+         ELEMENTS_INSTRUMENT_DISPATCH(limits, _main_element);
+         limits_ = _main_element.limits(bctx);
+      }
       if (limits_.min != _current_limits.min || limits_.max != _current_limits.max)
       {
          _current_limits = limits_;
@@ -61,15 +104,68 @@
       cairo_destroy(context_);
    }
 
+#if defined(ELEMENTS_ENABLE_INSTRUMENTATION)
+   namespace
+   {
+      // Number of bytes (assuming 32-bit ARGB) covered by the damaged area
+      // the host asked us to repaint.
+      std::size_t damage_bytes(cairo_t* context_)
+      {
+         std::size_t bytes = 0;
+         if (auto list = cairo_copy_clip_rectangle_list(context_))
+         {
+            if (list->status == CAIRO_STATUS_SUCCESS)
+            {
+               for (int i = 0; i != list->num_rectangles; ++i)
+               {
+                  auto const& r = list->rectangles[i];
+                  bytes += std::size_t(r.width * r.height) * 4;
+               }
+            }
+            cairo_rectangle_list_destroy(list);
+         }
+         return bytes;
+      }
+   }
+#endif
+
    void view::draw(cairo_t* context_)
    {
       if (_content.empty())
          return;
 
+      ELEMENTS_INSTRUMENT_FRAME(_recorder, draw_frame, "draw");
+#if defined(ELEMENTS_ENABLE_INSTRUMENTATION)
+      _recorder.add_damage(damage_bytes(context_));
+#endif
+
       // Update the limits and constrain the window size to the limits
       set_limits();
 
-      canvas cnv{*context_};
+      if (_use_display_list || _parallel_draw)
+      {
+         // Record the frame, then optimize and replay it
+         _display_list.clear();
+         {
+            canvas cnv{*context_, _display_list};
+            draw(cnv);
+         }
+         ELEMENTS_INSTRUMENT_PHASE(draw);
+         _display_list.optimize();
+         if (_parallel_draw)
+            _display_list.replay(*context_, shared_executor());
+         else
+            _display_list.replay(*context_);
+      }
+      else
+      {
+         canvas cnv{*context_};
+         draw(cnv);
+      }
+   }
+
+   void view::draw(canvas& cnv)
+   {
       auto size_ = size();
       rect subj_bounds = {0, 0, size_.x, size_.y};
       context ctx{*this, cnv, &_main_element, subj_bounds};
@@ -77,19 +173,26 @@
       // layout the subject only if the window bounds changes
       if (subj_bounds != _current_bounds)
       {
+         ELEMENTS_INSTRUMENT_PHASE(layout);
+         ELEMENTS_INSTRUMENT_DISPATCH(layout, _main_element);
          _current_bounds = subj_bounds;
          _main_element.layout(ctx);
       }
 
       // draw the subject
+      ELEMENTS_INSTRUMENT_PHASE(draw);
+      ELEMENTS_INSTRUMENT_DISPATCH(draw, _main_element);
       _main_element.draw(ctx);
    }
 
    namespace
    {
       template <typename F, typename This>
-      void with_context_do(F f, This& self, rect _current_bounds)
+      void with_context_do(
+         F f, This& self, rect _current_bounds
+       , [[maybe_unused]] char const* what)
       {
+         ELEMENTS_INSTRUMENT_FRAME(self.instrumentation(), event, what);
          auto surface_ = cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, nullptr);
          auto context_ = cairo_create(surface_);
          canvas cnv{*context_};
@@ -108,26 +211,129 @@
          return;
 
       with_context_do(
-         [](auto const& ctx, auto& _main_element) { _main_element.layout(ctx); },
-         *this, _current_bounds
+         [](auto const& ctx, auto& _main_element)
+         {
+            ELEMENTS_INSTRUMENT_PHASE(layout);
+            ELEMENTS_INSTRUMENT_DISPATCH(layout, _main_element);
+            _main_element.layout(ctx);
+         },
+         *this, _current_bounds, "layout"
       );
 
       refresh();
    }
 
+   void view::swap_content(layers_vector& layers, std::uint64_t generation)
+   {
+      // Drop stale builds
+      if (generation != _content_generation)
+         return;
+
+      _content.end_focus();
+      _content = std::move(layers);
+      std::reverse(_content.begin(), _content.end());
+      _content.reset();
+      set_limits();
+      layout();
+   }
+
    void view::layout(element& element)
    {
       if (_current_bounds.is_empty())
          return;
 
       with_context_do(
-         [](auto const& ctx, auto& _main_element) { _main_element.layout(ctx); },
-         *this, _current_bounds
+         [](auto const& ctx, auto& _main_element)
+         {
+            ELEMENTS_INSTRUMENT_PHASE(layout);
+            ELEMENTS_INSTRUMENT_DISPATCH(layout, _main_element);
+            _main_element.layout(ctx);
+         },
+         *this, _current_bounds, "layout"
       );
 
       refresh(element);
    }
 
+   void view::in_layer_context_do(element& e, context_function f)
+   {
+      if (_current_bounds.is_empty())
+         return;
+
+      with_context_do(
+         [this, &e, &f](auto const& ctx, auto& _main_element)
+         {
+            // Get the context of the layer composite, then that of the layer
+            _main_element.in_context_do(ctx, _content,
+               [this, &e, &f](context const& lctx)
+               {
+                  for (std::size_t ix = 0; ix != _content.size(); ++ix)
+                  {
+                     if (_content[ix].get() == &e)
+                     {
+                        context ectx{lctx, &e, _content.bounds_of(lctx, ix)};
+                        f(ectx);
+                        break;
+                     }
+                  }
+               }
+            );
+         },
+         *this, _current_bounds, "in_layer_context_do"
+      );
+   }
+
+   void view::layout_layer(element& e)
+   {
+      // Lay out only the given layer, and refresh only its bounds
+      in_layer_context_do(e,
+         [&e](context const& ectx)
+         {
+            {
+               ELEMENTS_INSTRUMENT_PHASE(layout);
+               ELEMENTS_INSTRUMENT_DISPATCH(layout, e);
+               e.layout(ectx);
+            }
+            e.refresh(ectx, e);
+         }
+      );
+   }
+
+   void view::refresh_layer(element& e)
+   {
+      in_layer_context_do(e,
+         [&e](context const& ectx)
+         {
+            e.refresh(ectx, e);
+         }
+      );
+   }
+
+   // The innermost element in the focus chain
+   element* view::focus_leaf()
+   {
+      element* e = _main_element.focus();
+      while (e)
+      {
+         auto next = e->focus();
+         if (!next || next == e)
+            break;
+         e = next;
+      }
+      return e;
+   }
+
+   // Refresh only the elements whose focus state changed: the previous
+   // focus, if any, and the current one.
+   void view::refresh_focus(element* prev_focus)
+   {
+      auto focus = focus_leaf();
+      if (prev_focus && prev_focus != focus)
+         refresh(*prev_focus);
+      if (focus)
+         refresh(*focus);
+   }
+
    float view::scale() const
    {
       return _main_element.scale();
@@ -141,6 +347,13 @@
 
    void view::refresh()
    {
+      if (defer_refresh())
+         return;
+      if (_debug_refresh)
+         log_full_refresh(nullptr);
+#if defined(ELEMENTS_ENABLE_INSTRUMENTATION)
+      _recorder.add_refresh();
+#endif
       // Allow refresh to be called from another thread
       _io.post(
          [this]()
@@ -152,6 +365,22 @@
 
    void view::refresh(rect area)
    {
+      refresh(area, nullptr);
+   }
+
+   void view::refresh(rect area, element const* source)
+   {
+      if (defer_refresh())
+         return;
+      if (_debug_refresh)
+      {
+         auto size_ = size();
+         if (area.includes(rect{0, 0, size_.x, size_.y}))
+            log_full_refresh(source);
+      }
+#if defined(ELEMENTS_ENABLE_INSTRUMENTATION)
+      _recorder.add_refresh();
+#endif
       // Allow refresh to be called from another thread
       _io.post(
          [this, area]()
@@ -161,16 +390,30 @@
       );
    }
 
+   namespace
+   {
+      // Let the element requesting the refresh and its ancestors know
+      void notify_damaged(context const& ctx)
+      {
+         for (auto c = &ctx; c; c = c->parent)
+         {
+            if (c->element)
+               c->element->damaged(*c);
+         }
+      }
+   }
+
    void view::refresh(context const& ctx, rect area)
    {
+      notify_damaged(ctx);
       auto tl = ctx.canvas.user_to_device(area.top_left());
       auto br = ctx.canvas.user_to_device(area.bottom_right());
-      refresh({tl.x, tl.y, br.x, br.y});
+      refresh({tl.x, tl.y, br.x, br.y}, ctx.element);
    }
 
    void view::refresh(element& element, int outward)
    {
-      if (_current_bounds.is_empty())
+      if (_current_bounds.is_empty() || defer_refresh())
          return;
 
       _io.post(
@@ -181,7 +424,7 @@
                {
                   _main_element.refresh(ctx, element, outward);
                },
-               *this, _current_bounds
+               *this, _current_bounds, "refresh"
             );
          }
       );
@@ -189,6 +432,7 @@
 
    void view::refresh(context const& ctx, int outward)
    {
+      notify_damaged(ctx);
       context const* ctx_ptr = &ctx;
       while (outward > 0 && ctx_ptr)
       {
@@ -199,12 +443,43 @@
       {
          auto tl = ctx.canvas.user_to_device(ctx_ptr->bounds.top_left());
          auto br = ctx.canvas.user_to_device(ctx_ptr->bounds.bottom_right());
-         refresh({tl.x, tl.y, br.x, br.y});
+         refresh({tl.x, tl.y, br.x, br.y}, ctx_ptr->element);
       }
    }
 
+   void view::log_full_refresh(element const* source)
+   {
+      std::clog
+         << "elements: full view refresh requested by "
+         << (source? source->class_name() : std::string{"view::refresh()"})
+         << std::endl;
+   }
+
+   // While a model_transaction on this view is in effect, refreshes are
+   // coalesced into a single refresh of the whole view, done when the
+   // outermost transaction ends.
+   bool view::defer_refresh()
+   {
+      if (_refresh_batch.load() == 0)
+         return false;
+      _refresh_deferred = true;
+      return true;
+   }
+
+   void view::begin_refresh_batch()
+   {
+      ++_refresh_batch;
+   }
+
+   void view::end_refresh_batch()
+   {
+      if (--_refresh_batch == 0 && _refresh_deferred.exchange(false))
+         refresh();
+   }
+
    void view::click(mouse_button btn)
    {
+      flush_input();
       _current_button = btn;
       if (_content.empty())
          return;
@@ -218,13 +493,129 @@
                elements::relinquish_focus(_content, ctx);
             refresh(_main_element);
          },
-         *this, _current_bounds
+         *this, _current_bounds, "click"
       );
    }
 
    void view::drag(mouse_button btn)
    {
       _current_button = btn;
+      if (!defer_input({input_kind::drag, btn.pos, {}, btn}))
+         dispatch_drag(btn);
+   }
+
+   void view::cursor(point p, cursor_tracking status)
+   {
+      if (status != cursor_tracking::hovering)
+      {
+         flush_input();
+         _motion_history.clear();
+         dispatch_cursor(p, status);
+      }
+      else if (!defer_input({input_kind::cursor, p, {}, {}}))
+      {
+         dispatch_cursor(p, status);
+      }
+   }
+
+   void view::scroll(point dir, point p)
+   {
+      if (!defer_input({input_kind::scroll, p, dir, {}}))
+         dispatch_scroll(dir, p);
+   }
+
+   void view::coalesce_input(bool state)
+   {
+      if (!state)
+         flush_input();
+      _coalesce_input = state;
+   }
+
+   namespace
+   {
+      // We keep this many of the latest motion samples
+      constexpr std::size_t max_motion_history = 16;
+
+      bool same_button(mouse_button const& a, mouse_button const& b)
+      {
+         return a.down == b.down && a.state == b.state && a.modifiers == b.modifiers;
+      }
+   }
+
+   // Returns true if the event e is held back, to be merged with other
+   // events of the same kind and dispatched later (see flush_input).
+   // Returns false if e should be dispatched now.
+   bool view::defer_input(pending_input const& e)
+   {
+      auto now = std::chrono::steady_clock::now();
+      auto& pending = _pending_input;
+
+      // A different kind of event (or a drag with a different button state)
+      // ends the current run
+      if (pending.kind != e.kind
+         || (e.kind == input_kind::drag && !same_button(pending.btn, e.btn)))
+      {
+         flush_input();
+      }
+
+      if (e.kind != input_kind::scroll)
+      {
+         // A new gesture starts a new history
+         if (!_motion_history.empty() && e.kind != _motion_kind)
+            _motion_history.clear();
+         _motion_kind = e.kind;
+         if (_motion_history.size() == max_motion_history)
+            _motion_history.erase(_motion_history.begin());
+         _motion_history.push_back({e.pos, now});
+      }
+
+      if (!_coalesce_input || (pending.kind == input_kind::none && now >= _next_input))
+      {
+         _next_input = now + _frame_interval;
+         return false;
+      }
+
+      if (pending.kind == input_kind::none)
+      {
+         pending = e;
+      }
+      else
+      {
+         pending.pos = e.pos;
+         pending.dir.x += e.dir.x;
+         pending.dir.y += e.dir.y;
+         pending.btn = e.btn;
+      }
+      return true;
+   }
+
+   void view::flush_input()
+   {
+      if (_pending_input.kind == input_kind::none)
+         return;
+
+      auto e = _pending_input;
+      _pending_input.kind = input_kind::none;
+      _next_input = std::chrono::steady_clock::now() + _frame_interval;
+
+      switch (e.kind)
+      {
+         case input_kind::drag:
+            dispatch_drag(e.btn);
+            break;
+         case input_kind::cursor:
+            dispatch_cursor(e.pos, cursor_tracking::hovering);
+            break;
+         case input_kind::scroll:
+            dispatch_scroll(e.dir, e.pos);
+            break;
+         default:
+            break;
+      }
+   }
+
+   void view::dispatch_drag(mouse_button btn)
+   {
       if (_content.empty())
          return;
 
@@ -233,11 +624,11 @@
          {
             _main_element.drag(ctx, btn);
          },
-         *this, _current_bounds
+         *this, _current_bounds, "drag"
       );
    }
 
-   void view::cursor(point p, cursor_tracking status)
+   void view::dispatch_cursor(point p, cursor_tracking status)
    {
       if (_content.empty())
          return;
@@ -248,11 +639,11 @@
             if (!_main_element.cursor(ctx, p, status))
                set_cursor(cursor_type::arrow);
          },
-         *this, _current_bounds
+         *this, _current_bounds, "cursor"
       );
    }
 
-   void view::scroll(point dir, point p)
+   void view::dispatch_scroll(point dir, point p)
    {
       if (_content.empty())
          return;
@@ -262,12 +653,13 @@
          {
             _main_element.scroll(ctx, dir, p);
          },
-         *this, _current_bounds
+         *this, _current_bounds, "scroll"
       );
    }
 
    bool view::key(key_info const& k)
    {
+      flush_input();
       if (_content.empty())
          return false;
 
@@ -277,13 +669,14 @@
          {
              handled = _main_element.key(ctx, k);
          },
-         *this, _current_bounds
+         *this, _current_bounds, "key"
       );
       return handled;
    }
 
    bool view::text(text_info const& info)
    {
+      flush_input();
       if (_content.empty())
          return false;
 
@@ -293,7 +686,7 @@
          {
              handled = _main_element.text(ctx, info);
          },
-         *this, _current_bounds
+         *this, _current_bounds, "text"
       );
       return handled;
    }
@@ -367,7 +760,7 @@
                   }
                );
             },
-            *this, _current_bounds
+            *this, _current_bounds, "relinquish_focus"
          );
       }
       _is_focus = false;
@@ -375,6 +768,7 @@
 
    void view::track_drop(drop_info const& info, cursor_tracking status)
    {
+      flush_input();
       if (_content.empty())
          return;
 
@@ -383,12 +777,13 @@
          {
             _main_element.track_drop(ctx, info, status);
          },
-         *this, _current_bounds
+         *this, _current_bounds, "track_drop"
       );
    }
 
    bool view::drop(drop_info const& info)
    {
+      flush_input();
       if (_content.empty())
          return false;
 
@@ -398,13 +793,32 @@
          {
             handled = _main_element.drop(ctx, info);
          },
-         *this, _current_bounds
+         *this, _current_bounds, "drop"
       );
       return handled;
    }
 
    void view::poll()
    {
+      deliver_models();
+      if (_pending_input.kind != input_kind::none
+         && std::chrono::steady_clock::now() >= _next_input)
+      {
+         flush_input();
+      }
+      if (!_animations.empty())
+      {
+         auto now = std::chrono::steady_clock::now();
+         if (now >= _next_frame)
+         {
+            // Keep to a steady cadence, but don't try to catch up on
+            // missed frames
+            _next_frame += _frame_interval;
+            if (_next_frame <= now)
+               _next_frame = now + _frame_interval;
+            tick_animations(now);
+         }
+      }
       _io.poll();
       if (!_tracking.empty())
       {
@@ -438,6 +852,159 @@
          _tracking.erase(&e);
    }
 
+   view::animation_id view::animate(animation_function f)
+   {
+      auto now = std::chrono::steady_clock::now();
+      if (_animations.empty() && !_ticking)
+         _next_frame = now;   // Start ticking at the next poll
+      auto id = _next_animation_id++;
+      (_ticking? _added_animations : _animations).push_back({id, std::move(f), now});
+      return id;
+   }
+
+   void view::stop_animation(animation_id id)
+   {
+      // We can't erase here, since this may be called from an animation
+      // function. Stopped animations are erased after the next tick.
+      for (auto* list : {&_animations, &_added_animations})
+      {
+         for (auto& a : *list)
+         {
+            if (a.id == id)
+               a.f = nullptr;
+         }
+      }
+   }
+
+   void view::frame_rate(float fps)
+   {
+      using namespace std::chrono;
+      _frame_interval = duration_cast<frame_duration>(std::chrono::duration<float>{1.0f / fps});
+   }
+
+   float view::frame_rate() const
+   {
+      return 1.0f / std::chrono::duration<float>{_frame_interval}.count();
+   }
+
+   void view::tick_animations(time_point now)
+   {
+      // Animations added while ticking are held in _added_animations, and
+      // start at the next frame.
+      rect damage;
+      _ticking = true;
+      for (auto& a : _animations)
+      {
+         if (!a.f)
+            continue;
+
+         animation_tick tick{now, now - a.last};
+         a.last = now;
+         if (!a.f(tick))
+            a.f = nullptr;
+         if (!tick.damage.is_empty())
+            damage = damage.is_empty()? tick.damage : max(damage, tick.damage);
+      }
+      _ticking = false;
+
+      _animations.erase(
+         std::remove_if(_animations.begin(), _animations.end(),
+            [](auto const& a) { return !a.f; }),
+         _animations.end()
+      );
+      for (auto& a : _added_animations)
+      {
+         if (a.f)
+            _animations.push_back(std::move(a));
+      }
+      _added_animations.clear();
+
+      if (!damage.is_empty())
+         refresh(damage);
+   }
+
+   void view::track(atomic_model_base& m)
+   {
+      if (m._view == this)
+         return;
+      if (m._view)
+         m._view->untrack(m);
+      m._view = this;
+      _models.push_back(&m);
+
+      // Deliver whatever was set before we started tracking
+      m._pending = true;
+   }
+
+   void view::untrack(atomic_model_base& m)
+   {
+      if (m._view != this)
+         return;
+      m._view = nullptr;
+      auto i = std::find(_models.begin(), _models.end(), &m);
+
+      // While delivering, leave a hole so deliver_models does not skip the
+      // next model. The holes are removed after the delivery.
+      if (_delivering_models)
+         *i = nullptr;
+      else
+         _models.erase(i);
+   }
+
+   void view::deliver_models()
+   {
+      // Producers may set the models at any rate. We deliver only the
+      // latest values, at most once per frame. The update functions
+      // typically refresh the linked elements; we do this before polling
+      // the io_context so those refreshes are handled in the same poll.
+      if (_models.empty())
+         return;
+      auto now = std::chrono::steady_clock::now();
+      if (now - _models_delivered < _frame_interval)
+         return;
+      _models_delivered = now;
+
+      // Index based, as update functions may track models. Models untracked
+      // in the meantime leave holes (see untrack).
+      _delivering_models = true;
+      for (std::size_t i = 0; i != _models.size(); ++i)
+      {
+         auto m = _models[i];
+         if (m && m->_pending.exchange(false, std::memory_order_acquire))
+            m->deliver();
+      }
+      _delivering_models = false;
+      std::erase(_models, nullptr);
+   }
+
+   model_transaction::model_transaction()
+   {
+      ++detail::model_transaction_depth();
+   }
+
+   model_transaction::model_transaction(view& view_)
+    : _view(&view_)
+   {
+      ++detail::model_transaction_depth();
+      _view->begin_refresh_batch();
+   }
+
+   model_transaction::~model_transaction()
+   {
+      auto& depth = detail::model_transaction_depth();
+      if (depth == 1)
+         detail::commit_model_updates();
+      --depth;
+      if (_view)
+         _view->end_refresh_batch();
+   }
+
+   atomic_model_base::~atomic_model_base()
+   {
+      if (_view)
+         _view->untrack(*this);
+   }
+
    void view::in_context_do(element& e, context_function f)
    {
       if (_content.empty())
@@ -448,7 +1015,7 @@
          {
             _main_element.in_context_do(ctx, e, f);
          },
-         *this, _current_bounds
+         *this, _current_bounds, "in_context_do"
       );
    }
 }